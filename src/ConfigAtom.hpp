@@ -18,6 +18,7 @@
  *
  */
 
+
 #ifndef CONFIG_ATOM_HPP
 #define CONFIG_ATOM_HPP
 
@@ -26,72 +27,112 @@
 #endif
 
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
 #include <stdexcept>
 #include <cstdio>
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <type_traits>
+#include <iostream>
 #ifndef Q_MOC_RUN
 #include <yaml-cpp/yaml.h>
 #include <json/json.h>
 #endif
 #include "ConfigBase.hpp"
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBinary.hpp"
 
 
 namespace configmaps {
 
+  /**
+   * @brief Scalar value of the configmaps data structure.
+   *
+   * The value is kept in one union selected by the type. Its text is only
+   * stored for strings and for values that are not parsed yet. Every
+   * ConfigItem reserves room for one atom, so sizeof(ConfigAtom) must stay
+   * within ConfigItem::ATOM_STORAGE_SIZE.
+   *
+   * Loaders that know the type of a scalar, e.g. the JSON reader for
+   * numbers, store the typed value and mark it as inferred. Such an atom
+   * behaves like an unparsed one whose text is the formatted value: the
+   * first getter fixes its type and may convert the value.
+   *
+   * Unparsed text that was a string in its source, e.g. a quoted YAML
+   * scalar or a string assigned in code, is marked as quoted. It parses
+   * like plain text, but its type is not inferred for the JSON output.
+   */
   class ConfigAtom : public ConfigBase {
   public:
-    enum ItemType {UNDEFINED_TYPE, INT_TYPE, UINT_TYPE, DOUBLE_TYPE,
-                   ULONG_TYPE, STRING_TYPE, BOOL_TYPE};
-
-    ConfigAtom() : luValue(0), iValue(0), uValue(0), dValue(0.0),
-                   parsed(false), type(UNDEFINED_TYPE) {}
+    enum ItemType : unsigned char {UNDEFINED_TYPE, INT_TYPE, UINT_TYPE,
+                                   DOUBLE_TYPE, ULONG_TYPE, STRING_TYPE,
+                                   BOOL_TYPE};
 
+    ConfigAtom() : ConfigBase(ATOM_NODE), type(UNDEFINED_TYPE), inferred(false), quoted(false) {
+      value.luValue = 0;
+    }
 
-    ConfigAtom(int val) : luValue(0), iValue(val),
-                          uValue(0), dValue(0.0),
-                          parsed(true), type(INT_TYPE) {}
+    ConfigAtom(int val) : ConfigBase(ATOM_NODE), type(INT_TYPE), inferred(false), quoted(false) {
+      value.iValue = val;
+    }
 
-    ConfigAtom(bool val) : luValue(0), iValue(val),
-                           uValue(0), dValue(0.0),
-                           parsed(true), type(BOOL_TYPE) {}
+    ConfigAtom(bool val) : ConfigBase(ATOM_NODE), type(BOOL_TYPE), inferred(false), quoted(false) {
+      value.iValue = val;
+    }
 
-    ConfigAtom(unsigned int val) : luValue(0), iValue(0),
-                                   uValue(val), dValue(0.0),
-                                   parsed(true), type(UINT_TYPE) {}
+    ConfigAtom(unsigned int val) : ConfigBase(ATOM_NODE), type(UINT_TYPE), inferred(false), quoted(false) {
+      value.uValue = val;
+    }
 
-    ConfigAtom(double val) : luValue(0), iValue(0),
-                             uValue(0), dValue(val),
-                             parsed(true), type(DOUBLE_TYPE) {}
+    ConfigAtom(double val) : ConfigBase(ATOM_NODE), type(DOUBLE_TYPE), inferred(false), quoted(false) {
+      value.dValue = val;
+    }
 
-    ConfigAtom(unsigned long val) : luValue(val), iValue(0),
-                                    uValue(0), dValue(0.0),
-                                    parsed(true), type(ULONG_TYPE) {}
+    ConfigAtom(unsigned long val) : ConfigBase(ATOM_NODE), type(ULONG_TYPE), inferred(false), quoted(false) {
+      value.luValue = val;
+    }
 
-    ConfigAtom(std::string val) : luValue(0), iValue(0),
-                                  uValue(0), dValue(0.0),
-                                  sValue(val.c_str()), parsed(false),
-                                  type(UNDEFINED_TYPE) {}
+    ConfigAtom(std::string val) : ConfigBase(ATOM_NODE),
+                                  type(UNDEFINED_TYPE), inferred(false), quoted(true),
+                                  sValue(std::move(val)) {
+      value.luValue = 0;
+    }
 
-    ConfigAtom(const char *val) : luValue(0), iValue(0),
-                                  uValue(0), dValue(0.0),
-                                  sValue(val), parsed(false),
-                                  type(UNDEFINED_TYPE) {}
+    ConfigAtom(const char *val) : ConfigBase(ATOM_NODE),
+                                  type(UNDEFINED_TYPE), inferred(false), quoted(true),
+                                  sValue(val) {
+      value.luValue = 0;
+    }
     /**
      * @brief Fills ConfigAtom item from YAML::Node.
      * @param n The node containing the informations for the object.
      * @throw Throws std::runtime_error if the type of the node is not scalar.
      */
-    ConfigAtom(const YAML::Node &n) {
+    ConfigAtom(const YAML::Node &n) : ConfigBase(ATOM_NODE), inferred(false), quoted(false) {
       if(n.Type() != YAML::NodeType::Scalar) {
         throw std::runtime_error("Failed to create ConfigAtom Item, YAML::Node was not a scalar type!");
       }
-      setUnparsedString(n.Scalar());
-      if(ConfigMap::debugLevel >= 1) {
+      // the non-specific tag "!" marks quoted scalars
+      if(n.Tag() == "!") {
+        setQuotedString(n.Scalar());
+      } else {
+        setUnparsedString(n.Scalar());
+      }
+      if(ConfigBase::debugLevel >= 1) {
         fprintf(stderr, " %s", this->toString().c_str());
       }
     }
 
-    ConfigAtom(const Json::Value &v) {
-      setUnparsedString(v.asString());
+    ConfigAtom(const Json::Value &v) : ConfigBase(ATOM_NODE), inferred(false), quoted(false) {
+      if(v.isString()) {
+        setQuotedString(v.asString());
+      } else {
+        setUnparsedString(v.asString());
+      }
     }
 
     operator int () {
@@ -111,7 +152,7 @@ namespace configmaps {
     }
 
     operator std::string () {
-      return (std::string)getString().c_str();
+      return getString();
     }
 
     operator bool () {
@@ -122,269 +163,514 @@ namespace configmaps {
       return type;
     }
 
-    inline bool testType(ItemType _type) {
-      if(type == UNDEFINED_TYPE) {
-        switch(_type) {
-        case INT_TYPE:
-          return parseInt();
-        case DOUBLE_TYPE:
-          return parseDouble();
-        case UINT_TYPE:
-          return parseUInt();
-        case ULONG_TYPE:
-          return parseULong();
-        case STRING_TYPE:
-          return parseString();
-        case BOOL_TYPE:
-          return parseBool();
-        default:
-          return false;
-        }
+    /**
+     * @brief Checks if the atom is of the given type or can be parsed as it.
+     *
+     * An unparsed or inferred atom stays as it is, the check does not fix
+     * its type.
+     */
+    inline bool testType(ItemType _type) const {
+      if(type == _type) return true;
+      if(type == UNDEFINED_TYPE || inferred) {
+        Value v;
+        return parseValue(_type, v);
       }
-      else if(type == _type) return true;
       return false;
     }
 
-    inline int getInt() {
-      if(type != UNDEFINED_TYPE && type != INT_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type getInt: %s - %s",
-                parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
-      }
+    /**
+     * @brief Whether the type was inferred by a loader and is not fixed yet.
+     */
+    inline bool isInferred() const {
+      return inferred;
+    }
 
-      if(!parsed) parseInt();
-      if(parsed) type = INT_TYPE;
+    /**
+     * @brief Whether the unparsed text was a string in its source.
+     */
+    inline bool isQuoted() const {
+      return quoted;
+    }
 
-      return iValue;
+    inline int getInt() {
+      return prepareGet(INT_TYPE, "getInt") ? value.iValue : 0;
     }
 
     inline double getDouble() {
-      if(type != UNDEFINED_TYPE && type != DOUBLE_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type getDouble: %s - %s",
-                parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
-      }
-      if(!parsed) parseDouble();
-      if(parsed) type = DOUBLE_TYPE;
-      return dValue;
+      return prepareGet(DOUBLE_TYPE, "getDouble") ? value.dValue : 0.0;
     }
 
     inline unsigned int getUInt() {
-      if(type != UNDEFINED_TYPE && type != UINT_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type getInt: %s - %s",
-                parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
-      }
-
-      if(!parsed) parseUInt();
-      if(parsed) type = UINT_TYPE;
-
-      return uValue;
+      return prepareGet(UINT_TYPE, "getUInt") ? value.uValue : 0;
     }
 
     inline unsigned long getULong() {
-      if(type != UNDEFINED_TYPE && type != ULONG_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type getULong: %s - %s",
-                parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
-      }
-      if(!parsed) parseULong();
-      if(parsed) type = ULONG_TYPE;
-      return luValue;
+      return prepareGet(ULONG_TYPE, "getULong") ? value.luValue : 0;
     }
 
     inline std::string getString() {
-      if(type != UNDEFINED_TYPE && type != STRING_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type getString: %s - %s",
-                parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
-      }
-      if(!parsed) parseString();
-      if(parsed) type = STRING_TYPE;
-      return sValue.c_str();
+      prepareGet(STRING_TYPE, "getString");
+      return sValue;
     }
 
-    inline std::string getUnparsedString() const {
+    inline const char* c_str() {
+      prepareGet(STRING_TYPE, "c_str");
       return sValue.c_str();
     }
 
-    inline bool getBool() {
-      if(type != UNDEFINED_TYPE && type != BOOL_TYPE) {
-        char text[50];
-        sprintf(text, "ConfigAtom parsing wrong type %d getBool: %s - %s",
-                type, parentName.c_str(), sValue.c_str());
-        throw std::runtime_error(text);
+    inline std::string getUnparsedString() const {
+      if(type == UNDEFINED_TYPE || type == STRING_TYPE) {
+        return sValue;
       }
+      return toString();
+    }
 
-      if(!parsed) parseBool();
-      if(parsed) type = BOOL_TYPE;
-
-      return iValue;
+    inline bool getBool() {
+      return prepareGet(BOOL_TYPE, "getBool") ? value.iValue : 0;
     }
 
-    inline void setInt(int value) {
-      iValue = value;
-      parsed = true;
-      type = INT_TYPE;
+    inline void setInt(int v) {
+      value.iValue = v;
+      setParsedType(INT_TYPE);
     }
 
-    inline void setDouble(double value) {
-      dValue = value;
-      parsed = true;
-      type = DOUBLE_TYPE;
+    inline void setDouble(double v) {
+      value.dValue = v;
+      setParsedType(DOUBLE_TYPE);
     }
 
-    inline void setUInt(unsigned int value) {
-      uValue = value;
-      parsed = true;
-      type = UINT_TYPE;
+    inline void setUInt(unsigned int v) {
+      value.uValue = v;
+      setParsedType(UINT_TYPE);
     }
 
-    inline void setULong(unsigned long value) {
-      luValue = value;
-      parsed = true;
-      type = ULONG_TYPE;
+    inline void setULong(unsigned long v) {
+      value.luValue = v;
+      setParsedType(ULONG_TYPE);
     }
 
-    inline void setString(const std::string &value) {
-      sValue = value.c_str();
-      parsed = true;
+    inline void setString(const std::string &v) {
+      sValue = v;
       type = STRING_TYPE;
+      inferred = false;
+      quoted = false;
     }
 
-    inline void setBool(bool value) {
-      iValue = value;
-      parsed = true;
-      type = BOOL_TYPE;
+    inline void setBool(bool v) {
+      value.iValue = v;
+      setParsedType(BOOL_TYPE);
     }
 
-    inline void setUnparsedString(const std::string &value) {
-      sValue = value.c_str();
-      parsed = false;
+    inline void setUnparsedString(const std::string &v) {
+      sValue = v;
+      value.luValue = 0;
       type = UNDEFINED_TYPE;
+      inferred = false;
+      quoted = false;
+    }
+
+    /**
+     * @brief Sets text that was given as string, e.g. a quoted YAML scalar
+     * or a JSON string. The getters parse it like unparsed text, but the
+     * JSON output keeps it a string even if it looks like a number.
+     */
+    inline void setQuotedString(const std::string &v) {
+      setUnparsedString(v);
+      quoted = true;
     }
 
-  inline std::string toString() const {
-  if (type == UNDEFINED_TYPE) {
-    return sValue;
-  } else if (type == INT_TYPE) {
-    return std::to_string(iValue);
-  } else if (type == UINT_TYPE) {
-    return std::to_string(uValue);
-  } else if (type == DOUBLE_TYPE) {
-    return std::to_string(dValue);
-  } else if (type == ULONG_TYPE) {
-    return std::to_string(luValue);
-  } else if (type == STRING_TYPE) {
-    return sValue;
-  } else if (type == BOOL_TYPE) {
-    return iValue ? "true" : "false";
+    /**
+     * @brief Marks the number or bool value set before as inferred from the
+     * source, so that other getters may still convert it.
+     */
+    inline void markInferred() {
+      inferred = type != UNDEFINED_TYPE && type != STRING_TYPE;
+    }
 
-  }
-  return "";
-}
+    /**
+     * @brief Size of a buffer that takes every formatted number, the
+     * longest are doubles with up to 24 characters.
+     */
+    static const size_t NUMBER_BUFFER_SIZE = 32;
+
+    /**
+     * @brief Writes the value of a number or bool atom into buffer.
+     *
+     * Numbers are written with std::to_chars in the shortest form that
+     * reads back to the same value. Integral doubles get a ".0" so they
+     * read back as doubles. The text is not null terminated.
+     * @param buffer Has to hold NUMBER_BUFFER_SIZE characters.
+     * @return The length of the text, 0 for strings and unparsed atoms.
+     */
+    inline size_t formatNumber(char *buffer) const {
+      char *end = buffer + NUMBER_BUFFER_SIZE;
+      std::to_chars_result r;
+      switch(type) {
+      case INT_TYPE:
+        r = std::to_chars(buffer, end, value.iValue);
+        break;
+      case UINT_TYPE:
+        r = std::to_chars(buffer, end, value.uValue);
+        break;
+      case DOUBLE_TYPE:
+        r = std::to_chars(buffer, end, value.dValue);
+        if(std::find_if(buffer, r.ptr, [](char c) {
+              return c == '.' || c == 'e' || c == 'n';}) == r.ptr) {
+          r.ptr = std::copy_n(".0", 2, r.ptr);
+        }
+        break;
+      case ULONG_TYPE:
+        r = std::to_chars(buffer, end, value.luValue);
+        break;
+      case BOOL_TYPE:
+        r.ptr = value.iValue ? std::copy_n("true", 4, buffer) :
+          std::copy_n("false", 5, buffer);
+        break;
+      default:
+        return 0;
+      }
+      return r.ptr - buffer;
+    }
+
+    inline std::string toString() const {
+      char buffer[NUMBER_BUFFER_SIZE];
+      size_t length = formatNumber(buffer);
+      if(length) {
+        return std::string(buffer, length);
+      }
+      return sValue;
+    }
 
 
     virtual void dumpToYamlEmitter(YAML::Emitter &emitter) const override {
-      std::string s = toString();
+      char buffer[NUMBER_BUFFER_SIZE + 1];
+      size_t length = formatNumber(buffer);
+      buffer[length] = '\0';
       if(ConfigBase::debugLevel >= 1) {
-        fprintf(stderr, "dump: %s\n", s.c_str());
+        fprintf(stderr, "dump: %s\n", length ? buffer : sValue.c_str());
+      }
+      if(length) {
+        emitter << buffer;
+      } else {
+        emitter << sValue;
       }
-      emitter << s;
     }
 
- virtual void dumpToJsonValue(Json::Value &root) const override {
-  if (type == BOOL_TYPE) {
-    root = iValue != 0;
-  } else {
-    auto str = toString();
-    if (str == "true" || str == "True" || str == "TRUE")
-    {
-      root = true;
+    virtual void dumpToJsonValue(Json::Value &root) const override {
+      int b = 0;
+      switch(jsonType(b)) {
+      case BOOL_TYPE:
+        root = b != 0;
+        break;
+      case INT_TYPE:
+        root = value.iValue;
+        break;
+      case UINT_TYPE:
+        root = value.uValue;
+        break;
+      case ULONG_TYPE:
+        root = (Json::UInt64)value.luValue;
+        break;
+      case DOUBLE_TYPE:
+        root = value.dValue;
+        break;
+      case UNDEFINED_TYPE: {
+        long l;
+        unsigned long lu;
+        double d;
+        if(parseNumber(sValue, l)) {
+          root = (Json::Int64)l;
+        } else if(parseNumber(sValue, lu)) {
+          root = (Json::UInt64)lu;
+        } else {
+          parseNumber(sValue, d);
+          root = d;
+        }
+        break;
+      }
+      default:
+        root = toString();
+        break;
+      }
+
+      if (ConfigBase::debugLevel >= 1) {
+        std::cout << "dump: " << root << std::endl;
+      }
+    }
+
+    virtual void dumpToJsonWriter(ConfigJsonWriter &writer) const override {
+      int b = 0;
+      char buffer[NUMBER_BUFFER_SIZE];
+      switch(jsonType(b)) {
+      case BOOL_TYPE:
+        writer.writeBool(b);
+        break;
+      case UNDEFINED_TYPE:
+        writer.writeNumber(sValue);
+        break;
+      case STRING_TYPE: {
+        size_t length = formatNumber(buffer);
+        writer.writeString(length ? std::string_view(buffer, length) :
+                           std::string_view(sValue));
+        break;
+      }
+      default:
+        writer.writeNumber(std::string_view(buffer, formatNumber(buffer)));
+        break;
+      }
     }
-    else if (str == "false" || str == "False" || str == "FALSE")
-    {
-      root = false;
+
+    virtual void dumpToBinaryWriter(ConfigBinaryWriter &writer) const override {
+      switch(type) {
+      case INT_TYPE:
+        writer.writeInt(value.iValue, inferred);
+        break;
+      case UINT_TYPE:
+        writer.writeUInt(value.uValue, inferred);
+        break;
+      case DOUBLE_TYPE:
+        writer.writeDouble(value.dValue, inferred);
+        break;
+      case ULONG_TYPE:
+        writer.writeULong(value.luValue, inferred);
+        break;
+      case BOOL_TYPE:
+        writer.writeBool(value.iValue, inferred);
+        break;
+      case STRING_TYPE:
+        writer.writeText(ConfigBinaryWriter::STRING_TAG, sValue);
+        break;
+      default:
+        writer.writeText(quoted ? ConfigBinaryWriter::QUOTED_TAG :
+                         ConfigBinaryWriter::UNPARSED_TAG, sValue);
+        break;
+      }
     }
-    else
-      root = str;
-  }
 
-  if (ConfigBase::debugLevel >= 1) {
-    std::cout << "dump: " << root << std::endl;
-  }
-}
+    /**
+     * Reads a double like std::from_chars does. Values beyond the range
+     * of double are accepted as well: they yield a subnormal value, zero
+     * or infinity like strtod. Depending on the standard library
+     * std::from_chars reports them as out of range without a value, then
+     * the text is read again with a stream in the classic locale.
+     */
+    static inline std::from_chars_result parseDouble(const char *first,
+                                                     const char *last,
+                                                     double &v) {
+      std::from_chars_result r = std::from_chars(first, last, v);
+      if(r.ec == std::errc::result_out_of_range) {
+        std::istringstream in(std::string(first, r.ptr));
+        in.imbue(std::locale::classic());
+        in >> v;
+        // the stream stores the largest finite value on overflow
+        if(in.fail() && std::fabs(v) == std::numeric_limits<double>::max()) {
+          v = std::copysign(std::numeric_limits<double>::infinity(), v);
+        }
+        r.ec = std::errc();
+      }
+      return r;
+    }
+
+    /**
+     * @brief Checks the JSON number syntax, e.g. "-1.5e3" but not "+1",
+     * "01" or " 1".
+     */
+    static inline bool isJsonNumber(std::string_view text) {
+      const char *p = text.data();
+      const char *end = p + text.size();
+      auto digits = [&p, end]() {
+        const char *first = p;
+        while(p != end && *p >= '0' && *p <= '9') ++p;
+        return p != first;
+      };
+      if(p != end && *p == '-') ++p;
+      if(p != end && *p == '0') {
+        ++p;
+      } else if(!digits()) {
+        return false;
+      }
+      if(p != end && *p == '.') {
+        ++p;
+        if(!digits()) return false;
+      }
+      if(p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if(p != end && (*p == '+' || *p == '-')) ++p;
+        if(!digits()) return false;
+      }
+      return p == end;
+    }
 
 
 
   private:
-    unsigned long luValue;
-    int iValue;
-    unsigned int uValue;
-    double dValue;
-    std::string sValue;
-    std::string parentName;
-    bool parsed;
+    union Value {
+      unsigned long luValue;
+      int iValue;
+      unsigned int uValue;
+      double dValue;
+    };
+
     ItemType type;
+    bool inferred;
+    bool quoted;
+    Value value;
+    std::string sValue;
 
-    inline bool parseInt() {
-      if(type != UNDEFINED_TYPE) {
-        throw std::runtime_error("ConfigAtom parsing wrong type line ...");
+    /*
+     * Parses or converts the value to the requested type if not done
+     * already. Returns false if the value does not fit the type.
+     */
+    inline bool prepareGet(ItemType _type, const char *getter) {
+      if(type == _type) {
+        inferred = false;
+        return true;
+      }
+      if(type != UNDEFINED_TYPE && !inferred) {
+        throw std::runtime_error(std::string("ConfigAtom parsing wrong type ") +
+                                 getter + ": " + getPath() + " - " +
+                                 toString());
+      }
+      Value v;
+      if(!parseValue(_type, v)) {
+        return false;
       }
-      return parsed = sscanf(sValue.c_str(), "%d", &iValue);
+      if(_type == STRING_TYPE) {
+        if(inferred) {
+          sValue = toString();
+        }
+        type = STRING_TYPE;
+        inferred = false;
+      } else {
+        value = v;
+        setParsedType(_type);
+      }
+      return true;
     }
 
-    inline bool parseUInt() {
-      if(type != UNDEFINED_TYPE) {
-        throw std::runtime_error("ConfigAtom parsing wrong type line ...");
+    // Numbers and booleans do not need their text anymore.
+    inline void setParsedType(ItemType _type) {
+      type = _type;
+      inferred = false;
+      quoted = false;
+      if(!sValue.empty()) {
+        std::string().swap(sValue);
       }
-      return parsed = sscanf(sValue.c_str(), "%u", &uValue);
     }
 
-    inline bool parseULong() {
-      if(type != UNDEFINED_TYPE) {
-        throw std::runtime_error("ConfigAtom parsing wrong type line ...");
+    // An inferred value is parsed from its formatted text.
+    inline bool parseValue(ItemType _type, Value &v) const {
+      if(inferred) {
+        char buffer[NUMBER_BUFFER_SIZE];
+        size_t length = formatNumber(buffer);
+        return parseText(_type, std::string_view(buffer, length), v);
+      }
+      return parseText(_type, sValue, v);
+    }
+
+    static inline bool parseText(ItemType _type, std::string_view text,
+                                 Value &v) {
+      v.luValue = 0;
+      switch(_type) {
+      case INT_TYPE:
+        return parseNumber(text, v.iValue);
+      case UINT_TYPE:
+        return parseNumber(text, v.uValue);
+      case ULONG_TYPE:
+        return parseNumber(text, v.luValue);
+      case DOUBLE_TYPE:
+        return parseNumber(text, v.dValue);
+      case STRING_TYPE:
+        return true;
+      case BOOL_TYPE:
+        return parseBool(text, v.iValue);
+      default:
+        return false;
       }
-      return parsed = sscanf(sValue.c_str(), "%lu", &luValue);
     }
 
-    inline bool parseDouble() {
-      if(type != UNDEFINED_TYPE) {
-        throw std::runtime_error("ConfigAtom parsing wrong type line ...");
+    /*
+     * Classifies the value for JSON output. Unparsed text in JSON number
+     * syntax yields UNDEFINED_TYPE and is written as it is, true and false
+     * in the YAML spellings yield BOOL_TYPE. Strings, quoted text and
+     * doubles that are not finite yield STRING_TYPE.
+     */
+    inline ItemType jsonType(int &b) const {
+      switch(type) {
+      case BOOL_TYPE:
+        b = value.iValue;
+        return BOOL_TYPE;
+      case DOUBLE_TYPE:
+        return std::isfinite(value.dValue) ? DOUBLE_TYPE : STRING_TYPE;
+      case UNDEFINED_TYPE:
+        if(quoted) {
+          return STRING_TYPE;
+        }
+        if(isJsonNumber(sValue)) {
+          return UNDEFINED_TYPE;
+        }
+        return parseBoolKeyword(sValue, b) ? BOOL_TYPE : STRING_TYPE;
+      default:
+        return type;
       }
-      return parsed = sscanf(sValue.c_str(), "%lf", &dValue);
     }
 
-    inline bool parseString() {
-      if(type != UNDEFINED_TYPE) {
-        throw std::runtime_error("ConfigAtom parsing wrong type line ...");
+    static inline std::string_view trimmed(std::string_view text) {
+      const char *space = " \t\r\n";
+      size_t front = text.find_first_not_of(space);
+      if(front == std::string_view::npos) {
+        return std::string_view();
       }
-      return parsed = true;
+      return text.substr(front, text.find_last_not_of(space) - front + 1);
     }
 
-  inline bool parseBool() {
-  if(type != UNDEFINED_TYPE) {
-    throw std::runtime_error("ConfigAtom parsing wrong type line ...");
-  }
-  sValue = trim(sValue);
-  if(sValue == "true" || sValue == "True" || sValue == "TRUE") {
-    iValue = true;
-    return parsed = true;
-  }
-
-  if(sValue == "false" || sValue == "False" || sValue == "FALSE") {
-    iValue = false;
-    return parsed = true;
-  }
+    /**
+     * Parses the whole text as number with std::from_chars, independent
+     * of the locale. Only a leading '+' and surrounding whitespace are
+     * accepted besides the number itself.
+     */
+    template <typename T>
+    static inline bool parseNumber(std::string_view text, T &v) {
+      text = trimmed(text);
+      if(!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+        if(!text.empty() && text[0] == '-') return false;
+      }
+      const char *end = text.data() + text.size();
+      std::from_chars_result r;
+      if constexpr (std::is_same<T, double>::value) {
+        r = parseDouble(text.data(), end, v);
+      } else {
+        r = std::from_chars(text.data(), end, v);
+      }
+      return r.ec == std::errc() && r.ptr == end;
+    }
 
-  return  parsed = sscanf(sValue.c_str(), "%d", &iValue);
-}
+    // Accepts true/false in the spellings of YAML and numbers.
+    static inline bool parseBool(std::string_view text, int &v) {
+      text = trimmed(text);
+      return parseBoolKeyword(text, v) || parseNumber(text, v);
+    }
 
+    static inline bool parseBoolKeyword(std::string_view text, int &v) {
+      switch(text.size()) {
+      case 4:
+        if(text == "true" || text == "True" || text == "TRUE") {
+          v = true;
+          return true;
+        }
+        break;
+      case 5:
+        if(text == "false" || text == "False" || text == "FALSE") {
+          v = false;
+          return true;
+        }
+        break;
+      default:
+        break;
+      }
+      return false;
+    }
 
   };
 
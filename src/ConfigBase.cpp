@@ -1,4 +1,8 @@
 #include "ConfigBase.hpp"
+#include "ConfigMap.hpp"
+#include "ConfigVector.hpp"
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBinary.hpp"
 #include <iostream>
 #include <yaml-cpp/yaml.h>
 #include <json/json.h>
@@ -6,14 +10,17 @@
 
 using namespace configmaps;
 
+// The emitter writes straight to the stream, so the text is never held
+// in memory as a whole. On errors the output ends where the emitter
+// stopped.
 void ConfigBase::toYamlStream(std::ostream &out) const{
-  YAML::Emitter emitter;
+  YAML::Emitter emitter(out);
   dumpToYamlEmitter(emitter);
   if(!emitter.good()){
     fprintf(stderr, "ERROR: ConfigMap::toYamlStream failed!\n");
     return;
   }
-  out << emitter.c_str() << std::endl;
+  out << std::endl;
 }
 
 void ConfigBase::toYamlFile(const std::string &filename) const{
@@ -32,14 +39,75 @@ std::string ConfigBase::toYamlString() const{
   return sout.str();
 }
 
-void ConfigBase::toJsonStream(std::ostream &out) const {
-  Json::Value root;
-  dumpToJsonValue(root);
-  out << root.toStyledString() << std::endl;
+void ConfigBase::toJsonStream(std::ostream &out, bool pretty) const {
+  ConfigJsonWriter writer(out, pretty);
+  writer.write(*this);
 }
 
-std::string ConfigBase::toJsonString() const {
-  std::ostringstream sout;
-  toJsonStream(sout);
-  return sout.str();
+std::string ConfigBase::toBinary() const {
+  ConfigBinaryWriter writer;
+  return writer.write(*this);
+}
+
+void ConfigBase::toBinaryFile(const std::string &filename) const {
+  std::ofstream f(filename.c_str(), std::ios::binary);
+  if(!f.good()){
+    fprintf(stderr, "ERROR: ConfigBase::toBinaryFile failed! "
+            "Could not open output file \"%s\"\n", filename.c_str());
+    return;
+  }
+  std::string data = toBinary();
+  f.write(data.data(), data.size());
+}
+
+std::string ConfigBase::toJsonString(bool pretty) const {
+  std::string s;
+  ConfigJsonWriter writer(s, pretty);
+  writer.write(*this);
+  return s;
+}
+
+// Finds the key under which parent holds the child, the child is given by
+// its node or, if it is empty, by its item.
+static std::string childKey(const ConfigBase &parent, const ConfigBase *node,
+                            const ConfigItem *item) {
+  switch(parent.getNodeType()) {
+  case ConfigBase::MAP_NODE:
+    for(const auto &it : static_cast<const ConfigMap&>(parent)) {
+      if(&it.second == item || (node && it.second.getNode() == node)) {
+        return it.first;
+      }
+    }
+    break;
+  case ConfigBase::VECTOR_NODE: {
+    const ConfigVector &vector = static_cast<const ConfigVector&>(parent);
+    for(size_t i = 0; i < vector.size(); ++i) {
+      if(&vector[i] == item || (node && vector[i].getNode() == node)) {
+        return std::to_string(i);
+      }
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return "?";
+}
+
+std::string ConfigBase::getParentName() const {
+  const ConfigBase *parent = getParent();
+  return parent ? childKey(*parent, this, NULL) : "";
+}
+
+std::string ConfigBase::getPath(const ConfigBase *parent,
+                                const ConfigBase *node,
+                                const ConfigItem *item) {
+  std::string path;
+  while(parent) {
+    path = "/" + childKey(*parent, node, item) + path;
+    node = parent;
+    item = NULL;
+    parent = parent->getParent();
+  }
+  return path.empty() ? "/" : path;
 }
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <ostream>
+#include <atomic>
+#include <utility>
 
 namespace YAML {
   class Emitter;
@@ -13,20 +15,85 @@ namespace Json {
 
 namespace configmaps {
 
+  class ConfigItem;
+  class ConfigJsonWriter;
+  class ConfigBinaryWriter;
+
   class ConfigBase {
   public:
+    /**
+     * @brief Kind of the concrete node, set once by the derived classes.
+     *
+     * ConfigItem dispatches on this tag instead of using dynamic_cast.
+     * LAZY_NODE marks a subtree of a lazily loaded document that is not
+     * converted yet, it never leaves ConfigItem.
+     */
+    enum NodeType : unsigned char {ATOM_NODE, MAP_NODE, VECTOR_NODE, LAZY_NODE};
+
     virtual ~ConfigBase() {}
-    ConfigBase(std::string s) : parentName(s) {}
-    ConfigBase() : parentName("") {}
+    explicit ConfigBase(NodeType t) : parent(NULL), nodeType(t) {}
+    // a copy is not part of the parent of the original
+    ConfigBase(const ConfigBase &other)
+      : parent(NULL), nodeType(other.nodeType) {}
+    ConfigBase(ConfigBase &&other) noexcept
+      : parent(NULL), nodeType(other.nodeType) {}
+    ConfigBase& operator=(const ConfigBase&) {return *this;}
+    ConfigBase& operator=(ConfigBase&&) noexcept {return *this;}
+
+    /**
+     * @brief Sets the map or vector that contains this node.
+     *
+     * The parent links replace stored key names, they are only followed
+     * to build the path of a node for error messages.
+     */
+    inline void setParent(ConfigBase *p) {
+      parent.store(p, std::memory_order_relaxed);
+    }
 
-    inline void setParentName(std::string s) {
-      parentName = s;
+    inline ConfigBase* getParent() const {
+      return parent.load(std::memory_order_relaxed);
     }
 
-    inline const std::string& getParentName() const {
-      return parentName;
+    /**
+     * @brief Replaces the parent from by to, false if it was another one.
+     *
+     * A shared node links to the container of one of its owners. The
+     * owners hand the link on with this, so that an owner never resets
+     * the link of another one.
+     */
+    inline bool replaceParent(ConfigBase *from, ConfigBase *to) {
+      return parent.compare_exchange_strong(from, to,
+                                            std::memory_order_relaxed);
     }
 
+    inline NodeType getNodeType() const {
+      return nodeType;
+    }
+
+    /**
+     * @brief Returns the key or index under which the parent holds this node.
+     *
+     * The key is searched in the parent, thus this is meant for error
+     * reporting only.
+     */
+    std::string getParentName() const;
+
+    /**
+     * @brief Builds the key path of this node, e.g. "/robot/links/0".
+     * @see getParentName()
+     */
+    std::string getPath() const {
+      return getPath(getParent(), this, NULL);
+    }
+
+    /**
+     * @brief Builds the key path of a child of parent, given by its node
+     * or, if the child is empty, by its item.
+     */
+    static std::string getPath(const ConfigBase *parent,
+                               const ConfigBase *node,
+                               const ConfigItem *item);
+
     virtual void dumpToYamlEmitter(YAML::Emitter &emitter) const = 0;
 
     void toYamlStream(std::ostream &out) const;
@@ -34,15 +101,90 @@ namespace configmaps {
     std::string toYamlString() const;
 
     virtual void dumpToJsonValue(Json::Value &root) const = 0;
+    virtual void dumpToJsonWriter(ConfigJsonWriter &writer) const = 0;
 
-    void toJsonStream(std::ostream &out) const;
-    std::string toJsonString() const;
+    /**
+     * @brief Writes the JSON text straight to the stream.
+     * @param pretty Indents the text, otherwise it has no whitespace.
+     */
+    void toJsonStream(std::ostream &out, bool pretty = true) const;
+    std::string toJsonString(bool pretty = true) const;
+
+    virtual void dumpToBinaryWriter(ConfigBinaryWriter &writer) const = 0;
+
+    /**
+     * @brief Encodes the node in the binary format of ConfigBinaryWriter.
+     */
+    std::string toBinary() const;
+    void toBinaryFile(const std::string &filename) const;
 
     static int debugLevel;
 
-  protected:
-      std::string parentName;
+  private:
+      // atomic since all owners of a shared node hand it on, see
+      // replaceParent()
+      std::atomic<ConfigBase*> parent;
+      NodeType nodeType;
 
   }; // end of class ConfigBase
 
+  /**
+   * @brief Base of the maps, vectors and lazy nodes that ConfigItems share.
+   *
+   * Atoms are stored inline in their item and are never shared, thus
+   * they do not carry the reference count.
+   */
+  class ConfigContainer : public ConfigBase {
+  public:
+    explicit ConfigContainer(NodeType t)
+      : ConfigBase(t), refs(1), shareable(false) {}
+    ConfigContainer(const ConfigContainer &other)
+      : ConfigBase(other), refs(1), shareable(false) {}
+    ConfigContainer(ConfigContainer &&other) noexcept
+      : ConfigBase(std::move(other)), refs(1), shareable(false) {}
+    ConfigContainer& operator=(const ConfigContainer&) {return *this;}
+    ConfigContainer& operator=(ConfigContainer&&) noexcept {return *this;}
+
+    /**
+     * @brief Reference count of a map or vector shared by ConfigItems.
+     *
+     * Copies of a ConfigItem share a shareable node until one of them
+     * changes it, see ConfigItem::detach(). A shared node is not changed
+     * anymore.
+     */
+    inline void retain() {
+      refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // returns true if the last reference was released
+    inline bool release() {
+      return refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    inline bool isShared() const {
+      return refs.load(std::memory_order_acquire) > 1;
+    }
+
+    /**
+     * @brief Marks a node that copies of a ConfigItem may share.
+     *
+     * A node is only shareable while no references into it are handed
+     * out, otherwise a change through such a reference would show up in
+     * the copies. ConfigItem clears the flag in detach() and copies a
+     * node that is not shareable instead of sharing it.
+     */
+    inline void setShareable(bool s) {
+      shareable.store(s, std::memory_order_relaxed);
+    }
+
+    inline bool isShareable() const {
+      return shareable.load(std::memory_order_relaxed);
+    }
+
+  private:
+      std::atomic<unsigned int> refs;
+      std::atomic<bool> shareable;
+
+  }; // end of class ConfigContainer
+
 }
@@ -0,0 +1,410 @@
+#include "ConfigBinary.hpp"
+#include "ConfigMap.hpp"
+#include "ConfigVector.hpp"
+#include "ConfigAtom.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace configmaps;
+
+std::string ConfigBinaryWriter::write(const ConfigBase &node) {
+  out.assign("CMB", 3);
+  out += (char)VERSION;
+  putFixed(0, 8);
+  node.dumpToBinaryWriter(*this);
+  setFixed(4, out.size(), 8);
+  putVarint(keys.size());
+  for(std::string_view key : keys) {
+    putVarint(key.size());
+    out.append(key.data(), key.size());
+  }
+  keyIndex.clear();
+  keys.clear();
+  return std::move(out);
+}
+
+void ConfigBinaryWriter::putVarint(uint64_t value) {
+  while(value >= 0x80) {
+    out += (char)(value | 0x80);
+    value >>= 7;
+  }
+  out += (char)value;
+}
+
+void ConfigBinaryWriter::putFixed(uint64_t value, int bytes) {
+  for(int i = 0; i < bytes; ++i) {
+    out += (char)(value >> (8 * i));
+  }
+}
+
+void ConfigBinaryWriter::setFixed(size_t offset, uint64_t value, int bytes) {
+  for(int i = 0; i < bytes; ++i) {
+    out[offset + i] = (char)(value >> (8 * i));
+  }
+}
+
+void ConfigBinaryWriter::writeEmpty() {
+  putTag(EMPTY_TAG, false);
+}
+
+void ConfigBinaryWriter::writeText(Tag tag, std::string_view text) {
+  putTag(tag, false);
+  putVarint(text.size());
+  out.append(text.data(), text.size());
+}
+
+void ConfigBinaryWriter::writeInt(int value, bool inferred) {
+  putTag(INT_TAG, inferred);
+  // zigzag keeps small negative numbers short
+  int64_t v = value;
+  putVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+void ConfigBinaryWriter::writeUInt(unsigned int value, bool inferred) {
+  putTag(UINT_TAG, inferred);
+  putVarint(value);
+}
+
+void ConfigBinaryWriter::writeULong(unsigned long value, bool inferred) {
+  putTag(ULONG_TAG, inferred);
+  putVarint(value);
+}
+
+void ConfigBinaryWriter::writeDouble(double value, bool inferred) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putTag(DOUBLE_TAG, inferred);
+  putFixed(bits, 8);
+}
+
+void ConfigBinaryWriter::writeBool(bool value, bool inferred) {
+  putTag(value ? TRUE_TAG : FALSE_TAG, inferred);
+}
+
+void ConfigBinaryWriter::beginEntry() {
+  Container &container = containers.back();
+  if(container.written == container.count) {
+    throw std::runtime_error("ConfigBinaryWriter: more entries than announced");
+  }
+  // entries behind 4 GiB fail in endContainer()
+  uint32_t offset = (uint32_t)(out.size() - container.entries);
+  if(container.isMap) {
+    mapEntries.back().second = offset;
+  } else {
+    setFixed(container.table + container.written * VECTOR_TABLE_ENTRY,
+             offset, 4);
+  }
+  ++container.written;
+}
+
+void ConfigBinaryWriter::beginContainer(Tag tag, size_t count) {
+  putTag(tag, false);
+  Container container;
+  container.isMap = tag == MAP_TAG;
+  container.size = out.size();
+  putFixed(0, 4);
+  putVarint(count);
+  container.table = out.size();
+  out.append(count * (container.isMap ? MAP_TABLE_ENTRY : VECTOR_TABLE_ENTRY),
+             '\0');
+  container.entries = out.size();
+  container.count = count;
+  container.written = 0;
+  containers.push_back(container);
+}
+
+void ConfigBinaryWriter::endContainer() {
+  Container container = containers.back();
+  containers.pop_back();
+  if(container.written != container.count) {
+    throw std::runtime_error("ConfigBinaryWriter: fewer entries than announced");
+  }
+  uint64_t size = out.size() - container.size - 4;
+  if(size > UINT32_MAX) {
+    throw std::runtime_error("ConfigBinaryWriter: container exceeds 4 GiB");
+  }
+  setFixed(container.size, size, 4);
+  if(container.isMap) {
+    // the nested maps took their entries off already
+    std::vector<std::pair<uint32_t, uint32_t>>::iterator first =
+      mapEntries.end() - container.count;
+    std::sort(first, mapEntries.end());
+    size_t pos = container.table;
+    for(std::vector<std::pair<uint32_t, uint32_t>>::iterator it = first;
+        it != mapEntries.end(); ++it) {
+      setFixed(pos, it->first, 4);
+      setFixed(pos + 4, it->second, 4);
+      pos += MAP_TABLE_ENTRY;
+    }
+    mapEntries.erase(first, mapEntries.end());
+  }
+}
+
+void ConfigBinaryWriter::beginMap(size_t count) {
+  beginContainer(MAP_TAG, count);
+}
+
+void ConfigBinaryWriter::key(std::string_view key) {
+  std::pair<std::unordered_map<std::string_view, size_t>::iterator, bool> it =
+    keyIndex.emplace(key, keys.size());
+  if(it.second) {
+    if(keys.size() > UINT32_MAX) {
+      throw std::runtime_error("ConfigBinaryWriter: too many keys");
+    }
+    keys.push_back(key);
+  }
+  mapEntries.emplace_back((uint32_t)it.first->second, 0);
+  beginEntry();
+  putVarint(it.first->second);
+}
+
+void ConfigBinaryWriter::endMap() {
+  endContainer();
+}
+
+void ConfigBinaryWriter::beginVector(size_t count) {
+  beginContainer(VECTOR_TAG, count);
+}
+
+void ConfigBinaryWriter::endVector() {
+  endContainer();
+}
+
+ConfigBinaryReader::ConfigBinaryReader(const char *data, size_t size)
+  : data(data), size(size) {
+}
+
+void ConfigBinaryReader::fail(const char *message) {
+  throw std::runtime_error(std::string("Invalid configmaps binary data: ") +
+                           message);
+}
+
+uint64_t ConfigBinaryReader::readVarint(const char *&pos, const char *end) {
+  uint64_t value = 0;
+  for(int shift = 0; shift < 64; shift += 7) {
+    if(pos == end) {
+      fail("truncated number");
+    }
+    unsigned char c = *pos++;
+    value |= (uint64_t)(c & 0x7F) << shift;
+    if(!(c & 0x80)) {
+      return value;
+    }
+  }
+  fail("number too long");
+}
+
+uint64_t ConfigBinaryReader::readFixed(const char *&pos, const char *end,
+                                       int bytes) {
+  if(end - pos < bytes) {
+    fail("truncated number");
+  }
+  uint64_t value = 0;
+  for(int i = 0; i < bytes; ++i) {
+    value |= (uint64_t)(unsigned char)pos[i] << (8 * i);
+  }
+  pos += bytes;
+  return value;
+}
+
+std::string_view ConfigBinaryReader::readText(const char *&pos,
+                                              const char *end) {
+  uint64_t length = readVarint(pos, end);
+  if(length > (uint64_t)(end - pos)) {
+    fail("truncated text");
+  }
+  std::string_view text(pos, length);
+  pos += length;
+  return text;
+}
+
+const char* ConfigBinaryReader::readHeader(const char *data, size_t size,
+                                           std::vector<std::string_view> &keys,
+                                           const char *&rootEnd) {
+  if(size < ConfigBinaryWriter::HEADER_SIZE || memcmp(data, "CMB", 3)) {
+    fail("missing header");
+  }
+  if(data[3] != ConfigBinaryWriter::VERSION) {
+    fail("unknown version");
+  }
+  const char *pos = data + 4;
+  const char *end = data + size;
+  uint64_t offset = readFixed(pos, end, 8);
+  if(offset < ConfigBinaryWriter::HEADER_SIZE || offset > size) {
+    fail("bad key table offset");
+  }
+  rootEnd = data + offset;
+  const char *keyPos = rootEnd;
+  uint64_t count = readVarint(keyPos, end);
+  if(count > (uint64_t)(end - keyPos)) {
+    fail("bad key count");
+  }
+  keys.clear();
+  keys.reserve(count);
+  for(uint64_t i = 0; i < count; ++i) {
+    keys.push_back(readText(keyPos, end));
+  }
+  return pos;
+}
+
+void ConfigBinaryReader::read(ConfigItem &root) {
+  const char *rootEnd;
+  const char *pos = readHeader(data, size, keys, rootEnd);
+  readValue(pos, rootEnd, keys, root);
+  if(pos != rootEnd) {
+    fail("unexpected data after the root value");
+  }
+}
+
+void ConfigBinaryReader::readValue(const char *&pos, const char *valueEnd,
+                                   const std::vector<std::string_view> &keys,
+                                   ConfigItem &item, int depth) {
+  if(pos == valueEnd) {
+    fail("truncated value");
+  }
+  unsigned char tag = *pos++;
+  bool inferred = tag & ConfigBinaryWriter::INFERRED_FLAG;
+  tag &= ~ConfigBinaryWriter::INFERRED_FLAG;
+  if(tag == ConfigBinaryWriter::MAP_TAG || tag == ConfigBinaryWriter::VECTOR_TAG) {
+    if(inferred) {
+      fail("bad container tag");
+    }
+    if(++depth > MAX_DEPTH) {
+      fail("nested too deeply");
+    }
+    uint64_t length = readFixed(pos, valueEnd, 4);
+    if(length > (uint64_t)(valueEnd - pos)) {
+      fail("truncated container");
+    }
+    const char *end = pos + length;
+    uint64_t count = readVarint(pos, end);
+    // every entry takes at least one byte besides its table entry, the
+    // table is only used by ConfigView
+    size_t width = tag == ConfigBinaryWriter::MAP_TAG ?
+      ConfigBinaryWriter::MAP_TABLE_ENTRY : ConfigBinaryWriter::VECTOR_TABLE_ENTRY;
+    if(count > (uint64_t)(end - pos) / (width + 1)) {
+      fail("bad element count");
+    }
+    pos += count * width;
+    if(tag == ConfigBinaryWriter::MAP_TAG) {
+      ConfigMap *map = item;
+      for(uint64_t i = 0; i < count; ++i) {
+        uint64_t index = readVarint(pos, end);
+        if(index >= keys.size()) {
+          fail("bad key index");
+        }
+        std::pair<ConfigMap::iterator, bool> it = map->try_emplace(keys[index]);
+        if(!it.second) {
+          fail("duplicate key");
+        }
+        it.first->second.setParent(map);
+        readValue(pos, end, keys, it.first->second, depth);
+      }
+      // the reader is done with the node, copies may share it now
+      map->setShareable(true);
+    } else {
+      ConfigVector *vector = item;
+      vector->reserve(count);
+      for(uint64_t i = 0; i < count; ++i) {
+        vector->append(ConfigItem());
+        readValue(pos, end, keys, vector->back(), depth);
+      }
+      vector->setShareable(true);
+    }
+    if(pos != end) {
+      fail("bad container size");
+    }
+    return;
+  }
+
+  if(tag == ConfigBinaryWriter::EMPTY_TAG && !inferred) {
+    return;
+  }
+  readAtom(pos[-1], pos, valueEnd, *item.getOrCreateAtom());
+}
+
+void ConfigBinaryReader::readAtom(unsigned char tag, const char *&pos,
+                                  const char *end, ConfigAtom &atom) {
+  bool inferred = tag & ConfigBinaryWriter::INFERRED_FLAG;
+  tag &= ~ConfigBinaryWriter::INFERRED_FLAG;
+  if(!inferred && (tag == ConfigBinaryWriter::UNPARSED_TAG ||
+                   tag == ConfigBinaryWriter::STRING_TAG ||
+                   tag == ConfigBinaryWriter::QUOTED_TAG)) {
+    std::string_view text = readText(pos, end);
+    if(tag == ConfigBinaryWriter::STRING_TAG) {
+      atom.setString(std::string(text));
+    } else if(tag == ConfigBinaryWriter::QUOTED_TAG) {
+      atom.setQuotedString(std::string(text));
+    } else {
+      atom.setUnparsedString(std::string(text));
+    }
+    return;
+  }
+  switch(tag) {
+  case ConfigBinaryWriter::INT_TAG: {
+    uint64_t v = readVarint(pos, end);
+    atom.setInt((int)(int64_t)((v >> 1) ^ (~(v & 1) + 1)));
+    break;
+  }
+  case ConfigBinaryWriter::UINT_TAG:
+    atom.setUInt((unsigned int)readVarint(pos, end));
+    break;
+  case ConfigBinaryWriter::ULONG_TAG:
+    atom.setULong(readVarint(pos, end));
+    break;
+  case ConfigBinaryWriter::DOUBLE_TAG: {
+    uint64_t bits = readFixed(pos, end, 8);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    atom.setDouble(v);
+    break;
+  }
+  case ConfigBinaryWriter::FALSE_TAG:
+  case ConfigBinaryWriter::TRUE_TAG:
+    atom.setBool(tag == ConfigBinaryWriter::TRUE_TAG);
+    break;
+  default:
+    fail("unknown tag");
+  }
+  if(inferred) {
+    atom.markInferred();
+  }
+}
+
+void ConfigBinaryReader::skipValue(const char *&pos, const char *end) {
+  if(pos == end) {
+    fail("truncated value");
+  }
+  unsigned char tag = *pos++ & ~ConfigBinaryWriter::INFERRED_FLAG;
+  switch(tag) {
+  case ConfigBinaryWriter::MAP_TAG:
+  case ConfigBinaryWriter::VECTOR_TAG: {
+    uint64_t length = readFixed(pos, end, 4);
+    if(length > (uint64_t)(end - pos)) {
+      fail("truncated container");
+    }
+    pos += length;
+    break;
+  }
+  case ConfigBinaryWriter::UNPARSED_TAG:
+  case ConfigBinaryWriter::STRING_TAG:
+  case ConfigBinaryWriter::QUOTED_TAG:
+    readText(pos, end);
+    break;
+  case ConfigBinaryWriter::INT_TAG:
+  case ConfigBinaryWriter::UINT_TAG:
+  case ConfigBinaryWriter::ULONG_TAG:
+    readVarint(pos, end);
+    break;
+  case ConfigBinaryWriter::DOUBLE_TAG:
+    readFixed(pos, end, 8);
+    break;
+  case ConfigBinaryWriter::EMPTY_TAG:
+  case ConfigBinaryWriter::FALSE_TAG:
+  case ConfigBinaryWriter::TRUE_TAG:
+    break;
+  default:
+    fail("unknown tag");
+  }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace configmaps {
+
+  class ConfigBase;
+  class ConfigItem;
+  class ConfigAtom;
+
+  /**
+   * @brief Writes the binary encoding of a ConfigItem tree.
+   *
+   * Every atom keeps its type, so a tree read back is equal to the
+   * written one, including unparsed text and inferred types. Layout of a
+   * document, all fixed size integers are little endian:
+   *
+   *   header     "CMB", version byte, uint64 offset of the key table
+   *   value      tag byte and its payload, the root value follows the header
+   *   key table  varint count, then varint length and bytes of each key
+   *
+   * Tags and their payload:
+   *
+   *   EMPTY_TAG                 none, an item without node
+   *   UNPARSED_TAG, STRING_TAG, varint length and bytes
+   *   QUOTED_TAG
+   *   INT_TAG                   zigzag encoded varint
+   *   UINT_TAG, ULONG_TAG       varint
+   *   DOUBLE_TAG                8 bytes IEEE 754
+   *   FALSE_TAG, TRUE_TAG       none
+   *   MAP_TAG                   uint32 byte size of the rest, varint count,
+   *                             entry table, then varint key index and
+   *                             value per entry
+   *   VECTOR_TAG                uint32 byte size of the rest, varint count,
+   *                             entry table, then the values
+   *
+   * The entry table of a map holds uint32 key index and uint32 offset of
+   * each entry, sorted by key index. The one of a vector holds the uint32
+   * offset of each value. Offsets count from the first entry, the tables
+   * allow ConfigView to look up keys and indices without scanning.
+   *
+   * QUOTED_TAG holds unparsed text that was a string in its source, see
+   * ConfigAtom::setQuotedString(). Atoms with an inferred type have
+   * INFERRED_FLAG set in their tag. The byte size of containers allows to
+   * skip them without decoding.
+   */
+  class ConfigBinaryWriter {
+  public:
+    enum Tag : unsigned char {EMPTY_TAG, UNPARSED_TAG, STRING_TAG, INT_TAG,
+                              UINT_TAG, DOUBLE_TAG, ULONG_TAG, FALSE_TAG,
+                              TRUE_TAG, MAP_TAG, VECTOR_TAG, QUOTED_TAG};
+    static const unsigned char INFERRED_FLAG = 0x80;
+    static const unsigned char VERSION = 3;
+    static const size_t HEADER_SIZE = 12;
+    // bytes per entry of the entry tables of maps and vectors
+    static const size_t MAP_TABLE_ENTRY = 8;
+    static const size_t VECTOR_TABLE_ENTRY = 4;
+
+    /**
+     * @brief Encodes the node as binary document.
+     * @throw std::runtime_error if a container exceeds 4 GiB.
+     */
+    std::string write(const ConfigBase &node);
+
+    void writeEmpty();
+    void writeText(Tag tag, std::string_view text);
+    void writeInt(int value, bool inferred);
+    void writeUInt(unsigned int value, bool inferred);
+    void writeULong(unsigned long value, bool inferred);
+    void writeDouble(double value, bool inferred);
+    void writeBool(bool value, bool inferred);
+
+    void beginMap(size_t count);
+    void key(std::string_view key);
+    void endMap();
+    void beginVector(size_t count);
+    void endVector();
+
+  private:
+    std::string out;
+    // keys are views into the written tree, they are only kept while
+    // writing
+    std::unordered_map<std::string_view, size_t> keyIndex;
+    std::vector<std::string_view> keys;
+    struct Container {
+      // offsets of the size field, the entry table and the first entry
+      size_t size;
+      size_t table;
+      size_t entries;
+      size_t count;
+      size_t written;
+      bool isMap;
+    };
+    std::vector<Container> containers;
+    // key indices and offsets of the entries of the open maps
+    std::vector<std::pair<uint32_t, uint32_t>> mapEntries;
+
+    void putVarint(uint64_t value);
+    void putFixed(uint64_t value, int bytes);
+    void setFixed(size_t offset, uint64_t value, int bytes);
+    void putTag(unsigned char tag, bool inferred) {
+      if(!containers.empty() && !containers.back().isMap) {
+        beginEntry();
+      }
+      out += (char)(inferred ? tag | INFERRED_FLAG : tag);
+    }
+    // records the offset of the next entry of the innermost container
+    void beginEntry();
+    void beginContainer(Tag tag, size_t count);
+    void endContainer();
+  }; // end of class ConfigBinaryWriter
+
+  /**
+   * @brief Decodes a binary document written by ConfigBinaryWriter.
+   *
+   * The data is checked while reading, broken or truncated documents
+   * throw std::runtime_error.
+   */
+  class ConfigBinaryReader {
+  public:
+    ConfigBinaryReader(const char *data, size_t size);
+
+    void read(ConfigItem &root);
+
+    // decoding helpers, they advance pos and throw at the end of the data
+    static uint64_t readVarint(const char *&pos, const char *end);
+    static uint64_t readFixed(const char *&pos, const char *end, int bytes);
+    static std::string_view readText(const char *&pos, const char *end);
+    [[noreturn]] static void fail(const char *message);
+
+    /**
+     * @brief Decodes an atom whose tag was read already.
+     * @throw std::runtime_error if the tag is no atom tag.
+     */
+    static void readAtom(unsigned char tag, const char *&pos, const char *end,
+                         ConfigAtom &atom);
+
+    // advances pos behind the value at pos
+    static void skipValue(const char *&pos, const char *end);
+
+    /**
+     * @brief Decodes the value at pos into item.
+     * @param keys The key table of the document.
+     */
+    static void readValue(const char *&pos, const char *end,
+                          const std::vector<std::string_view> &keys,
+                          ConfigItem &item, int depth = 0);
+
+    /**
+     * @brief Checks the header and reads the key table.
+     * @param rootEnd Is set to the end of the root value.
+     * @return The position of the root value.
+     */
+    static const char* readHeader(const char *data, size_t size,
+                                  std::vector<std::string_view> &keys,
+                                  const char *&rootEnd);
+
+  private:
+    static const int MAX_DEPTH = 1000;
+
+    const char *data;
+    size_t size;
+    std::vector<std::string_view> keys;
+  }; // end of class ConfigBinaryReader
+
+} // end of namespace configmaps
@@ -22,9 +22,32 @@
 #include "ConfigMap.hpp"
 #include "ConfigVector.hpp"
 #include "ConfigAtom.hpp"
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBinary.hpp"
 #include <sstream>
 #include <fstream>
 #include <exception>
+#include <list>
+#include <new>
+#include <yaml-cpp/parser.h>
+#include <yaml-cpp/eventhandler.h>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <system_error>
+#include <unordered_map>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef _WIN32
 #define POINTER void*
@@ -34,22 +57,81 @@
 
 namespace configmaps {
 
-  ConfigItem::ConfigItem() {
+  // Downcasts driven by the node type tag, NULL if the node is of
+  // another kind.
+  static inline ConfigMap* asMap(ConfigBase *node) {
+    return node && node->getNodeType() == ConfigBase::MAP_NODE ?
+      static_cast<ConfigMap*>(node) : NULL;
+  }
+
+  static inline ConfigVector* asVector(ConfigBase *node) {
+    return node && node->getNodeType() == ConfigBase::VECTOR_NODE ?
+      static_cast<ConfigVector*>(node) : NULL;
+  }
+
+  namespace {
+
+    /**
+     * @brief Subtree of a lazily loaded document that is not converted yet.
+     *
+     * ConfigItem replaces it by the converted map or vector on first
+     * access, see ConfigItem::materialize(). The dump functions are only
+     * there to complete the interface, they convert a temporary copy.
+     */
+    class ConfigLazyNode : public ConfigContainer {
+    public:
+      explicit ConfigLazyNode(const YAML::Node &node)
+        : ConfigContainer(LAZY_NODE), node(node) {
+        setShareable(true);
+      }
+
+      void dumpToYamlEmitter(YAML::Emitter &emitter) const override {
+        ConfigItem(node).dumpToYamlEmitter(emitter);
+      }
+
+      void dumpToJsonValue(Json::Value &root) const override {
+        ConfigItem(node).dumpToJsonValue(root);
+      }
+
+      void dumpToJsonWriter(ConfigJsonWriter &writer) const override {
+        ConfigItem(node).dumpToJsonWriter(writer);
+      }
+
+      void dumpToBinaryWriter(ConfigBinaryWriter &writer) const override {
+        ConfigItem(node).dumpToBinaryWriter(writer);
+      }
+
+      // YAML::Node is a shared handle, copies of the item share the source
+      YAML::Node node;
+    };
+
+  } // end of anonymous namespace
+
+  static_assert(sizeof(ConfigAtom) <= ConfigItem::ATOM_STORAGE_SIZE,
+                "ConfigAtom does not fit into the inline storage of ConfigItem");
+  static_assert(alignof(ConfigAtom) <= alignof(double),
+                "ConfigAtom needs a stricter alignment than ConfigItem provides");
+
+  ConfigItem::ConfigItem() : parent(NULL) {
     item = NULL;
     if(ConfigBase::debugLevel >= 2) {
       fprintf(stderr, "new d %lx %lx\n", (POINTER)this->item, (POINTER)this);
     }
   }
 
-  ConfigItem::ConfigItem(const YAML::Node &n) {
+  ConfigItem::ConfigItem(const YAML::Node &n) : parent(NULL) {
     ///@todo implement me!
     //create correct object type for the item:
     if(n.IsScalar()) {
-      item = new ConfigAtom(n);
+      item = new(atomStorage) ConfigAtom(n);
     } else if(n.IsSequence()) {
-      item = new ConfigVector(n);
+      ConfigVector *vector = new ConfigVector(n);
+      vector->setShareable(true);
+      item = vector;
     } else if(n.IsMap()) {
-      item = new ConfigMap(n);
+      ConfigMap *map = new ConfigMap(n);
+      map->setShareable(true);
+      item = map;
     } else {
       char error[128];
       sprintf(error, "Could not create ConfigItem from unknown YAML::NodeType! %d", n.Type());
@@ -58,31 +140,33 @@ namespace configmaps {
     }
   }
 
-  ConfigItem::ConfigItem(const Json::Value &v) {
+  ConfigItem::ConfigItem(const Json::Value &v) : parent(NULL) {
     ///@todo implement me!
     //create correct object type for the item:
     if(v.isArray()) {
-      item = new ConfigVector(v);
+      ConfigVector *vector = new ConfigVector(v);
+      vector->setShareable(true);
+      item = vector;
     }
     else if(v.isObject()) {
-      item = new ConfigMap(v);
+      ConfigMap *map = new ConfigMap(v);
+      map->setShareable(true);
+      item = map;
     }
     else {
-      item = new ConfigAtom(v);
+      item = new(atomStorage) ConfigAtom(v);
     }
   }
 
-  ConfigItem::ConfigItem(const ConfigItem &item) {
+  ConfigItem::ConfigItem(const ConfigItem &item) : parent(NULL) {
     this->item = NULL;
-    if(item.item) {
-      *this = *item.item;
-    }
+    *this = item;
     if(ConfigBase::debugLevel >= 2) {
       fprintf(stderr, "new d %lx %lx\n", (POINTER)this->item, (POINTER)this);
     }
   }
 
-  ConfigItem::ConfigItem(const ConfigBase &item) {
+  ConfigItem::ConfigItem(const ConfigBase &item) : parent(NULL) {
     this->item = NULL;
     *this = item;
     if(ConfigBase::debugLevel >= 2) {
@@ -90,48 +174,59 @@ namespace configmaps {
     }
   }
 
+  ConfigItem::ConfigItem(ConfigItem &&item) noexcept
+    : item(NULL), parent(NULL) {
+    // the new item is not part of the container of the old one, the
+    // container that takes it up sets the parent, see ConfigVector
+    takeNodeFrom(item);
+  }
+
+  ConfigItem::ConfigItem(ConfigBase &&item) : parent(NULL) {
+    this->item = NULL;
+    *this = std::move(item);
+  }
+
   ConfigItem& ConfigItem::operator=(const ConfigItem& item) {
-    if(item.item) {
+    if(this == &item) {
+      return *this;
+    }
+    if(item.hasInlineAtom()) {
       return *this = *item.item;
     }
-    else {
-      if(this->item) {
-        delete this->item;
-        this->item = NULL;
-      }
+    // a node that handed out references might still be changed through
+    // them, and a node shared into its own subtree would contain itself
+    ConfigContainer *node = item.container();
+    bool share = node && node->isShareable();
+    for(const ConfigBase *p = parent; share && p; p = p->getParent()) {
+      share = p != node;
+    }
+    if(node && !share) {
+      // the copy shares the shareable children, only this level is
+      // duplicated
+      *this = *node;
+      container()->setShareable(true);
       return *this;
     }
+    // maps and vectors are shared until one of the items changes them,
+    // retained first since item might be part of our current node
+    if(node) {
+      node->retain();
+    }
+    releaseNode();
+    this->item = node;
+    linkNode(NULL);
+    return *this;
   }
 
   ConfigItem& ConfigItem::operator=(const ConfigBase& item) {
-    if(this->item) {
-      if(ConfigBase::debugLevel >= 2) {
-        fprintf(stderr, "delete %lx\n", (POINTER)this->item);
-      }
-      delete this->item;
-      this->item = NULL;
-    }
     if(ConfigBase::debugLevel >= 2) {
       fprintf(stderr, "new = old %lx\n", (POINTER)this->item);
     }
-    const ConfigAtom* a = dynamic_cast<const ConfigAtom*>(&item);
-    if(a) {
-      this->item = new ConfigAtom(*a);
-      this->item->setParentName(parentName);
-    }
-    else {
-      const ConfigMap* m = dynamic_cast<const ConfigMap*>(&item);
-      if(m) {
-        this->item = new ConfigMap(*m);
-        this->item->setParentName(parentName);
-      }
-      else {
-        const ConfigVector *v = dynamic_cast<const ConfigVector*>(&item);
-        if(v) {
-          this->item = new ConfigVector(*v);
-          this->item->setParentName(parentName);
-        }
-      }
+    // clone before releasing our node, item might be part of it
+    if(item.getNodeType() == ConfigBase::ATOM_NODE) {
+      setAtom(ConfigAtom(static_cast<const ConfigAtom&>(item)));
+    } else {
+      setNode(cloneNode(item));
     }
     if(ConfigBase::debugLevel >= 2) {
       fprintf(stderr, "new = %lx  %lx\n", (POINTER)this->item, (POINTER)this);
@@ -139,29 +234,1144 @@ namespace configmaps {
     return *this;
   }
 
-  ConfigItem::~ConfigItem() {
+  ConfigItem& ConfigItem::operator=(ConfigItem&& item) noexcept {
+    if(this != &item) {
+      if(item.hasInlineAtom()) {
+        // item might be part of our current node, release it first
+        ConfigAtom value(std::move(*static_cast<ConfigAtom*>(item.item)));
+        item.releaseNode();
+        setAtom(std::move(value));
+      } else {
+        ConfigBase *node = item.item;
+        item.item = NULL;
+        setNode(node);
+        linkNode(item.parent);
+      }
+    }
+    return *this;
+  }
+
+  ConfigItem& ConfigItem::operator=(ConfigBase&& item) {
+    if(item.getNodeType() == ConfigBase::ATOM_NODE) {
+      setAtom(std::move(static_cast<ConfigAtom&>(item)));
+    } else {
+      setNode(moveNode(std::move(item)));
+    }
+    return *this;
+  }
+
+  void ConfigItem::swap(ConfigItem &other) noexcept {
+    ConfigItem tmp;
+    tmp.takeNodeFrom(*this);
+    takeNodeFrom(other);
+    other.takeNodeFrom(tmp);
+  }
+
+  ConfigBase* ConfigItem::cloneNode(const ConfigBase &node) {
+    switch(node.getNodeType()) {
+    case ConfigBase::MAP_NODE:
+      return new ConfigMap(static_cast<const ConfigMap&>(node));
+    case ConfigBase::VECTOR_NODE:
+      return new ConfigVector(static_cast<const ConfigVector&>(node));
+    case ConfigBase::LAZY_NODE:
+      return new ConfigLazyNode(static_cast<const ConfigLazyNode&>(node).node);
+    default:
+      // atoms are stored inline, see setAtom()
+      break;
+    }
+    return NULL;
+  }
+
+  ConfigBase* ConfigItem::moveNode(ConfigBase &&node) {
+    switch(node.getNodeType()) {
+    case ConfigBase::MAP_NODE:
+      return new ConfigMap(std::move(static_cast<ConfigMap&>(node)));
+    case ConfigBase::VECTOR_NODE:
+      return new ConfigVector(std::move(static_cast<ConfigVector&>(node)));
+    case ConfigBase::LAZY_NODE:
+      return new ConfigLazyNode(static_cast<ConfigLazyNode&>(node).node);
+    default:
+      // atoms are stored inline, see setAtom()
+      break;
+    }
+    return NULL;
+  }
+
+  void ConfigItem::setNode(ConfigBase *node) {
+    releaseNode();
+    item = node;
+    linkNode(NULL);
+  }
+
+  ConfigAtom* ConfigItem::setAtom(ConfigAtom &&atom) {
+    // the atom might be part of our current node, move it out first
+    ConfigAtom value(std::move(atom));
+    releaseNode();
+    ConfigAtom *a = new(atomStorage) ConfigAtom(std::move(value));
+    item = a;
+    item->setParent(parent);
+    return a;
+  }
+
+  void ConfigItem::releaseNode() {
+    if(!item) {
+      return;
+    }
     if(ConfigBase::debugLevel >= 2) {
       fprintf(stderr, "delete %lx\n", (POINTER)item);
     }
-    delete item;
+    if(hasInlineAtom()) {
+      item->~ConfigBase();
+    } else {
+      // the other owners of a shared node must not link to our parent
+      ConfigContainer *node = container();
+      node->replaceParent(parent, NULL);
+      if(node->release()) {
+        delete node;
+      }
+    }
+    item = NULL;
+  }
+
+  void ConfigItem::detach() {
+    resolve();
+    ConfigContainer *node = container();
+    if(!node) {
+      return;
+    }
+    if(node->isShared()) {
+      // the copy shares the children, only this level is duplicated
+      setNode(cloneNode(*node));
+      node = container();
+    } else if(!node->getParent()) {
+      // the last owner of a formerly shared node
+      node->setParent(parent);
+    }
+    // the caller might keep references into the node
+    if(node->isShareable()) {
+      node->setShareable(false);
+    }
+  }
+
+  void ConfigItem::takeNodeFrom(ConfigItem &other) {
+    // expects this item to be empty
+    if(other.hasInlineAtom()) {
+      item = new(atomStorage) ConfigAtom(std::move(*static_cast<ConfigAtom*>(other.item)));
+      other.releaseNode();
+      item->setParent(parent);
+    } else {
+      item = other.item;
+      other.item = NULL;
+      linkNode(other.parent);
+    }
+  }
+
+  /*
+   * A node that is not shared links to our parent. A shared node links
+   * to the parent of one of its owners, we take the link over if it
+   * pointed to from, i.e. the node was handed to us by its owner there,
+   * or to no parent at all. An owner clears the link to its parent when
+   * it releases the node, thus it never points to a freed container.
+   */
+  void ConfigItem::linkNode(ConfigBase *from) {
+    if(!item) {
+      return;
+    }
+    ConfigContainer *node = container();
+    if(!node || !node->isShared()) {
+      item->setParent(parent);
+    } else if(!node->replaceParent(from, parent)) {
+      node->replaceParent(NULL, parent);
+    }
+  }
+
+  ConfigContainer* ConfigItem::container() const {
+    // atoms are always stored inline, see setAtom()
+    if(!item || item->getNodeType() == ConfigBase::ATOM_NODE) {
+      return NULL;
+    }
+    return static_cast<ConfigContainer*>(item);
+  }
+
+  bool ConfigItem::hasInlineAtom() const {
+    return item && item->getNodeType() == ConfigBase::ATOM_NODE &&
+      item == reinterpret_cast<const ConfigAtom*>(atomStorage);
+  }
+
+  ConfigItem::~ConfigItem() {
+    releaseNode();
+  }
+
+  void ConfigItem::setLazy(const YAML::Node &n) {
+    // atoms are cheap to convert and are stored inline anyway
+    if(n.IsScalar()) {
+      setAtom(ConfigAtom(n));
+    } else if(n.IsSequence() || n.IsMap()) {
+      setNode(new ConfigLazyNode(n));
+    } else {
+      char error[128];
+      sprintf(error, "Could not create ConfigItem from unknown YAML::NodeType! %d", n.Type());
+      fprintf(stderr, "%s\n", error);
+      throw std::runtime_error(error);
+    }
+  }
+
+  void ConfigItem::materialize() const {
+    // converting does not change the value, thus it is done on const
+    // access as well
+    ConfigItem &self = const_cast<ConfigItem&>(*this);
+    YAML::Node n = static_cast<ConfigLazyNode*>(item)->node;
+    if(n.IsMap()) {
+      ConfigMap *map = new ConfigMap();
+      // same rules as ConfigMap(const YAML::Node&)
+      for(YAML::const_iterator it = n.begin(); it != n.end(); ++it) {
+        if(it->second.IsNull()) {
+          continue;
+        }
+        std::string key = it->first.as<std::string>();
+        auto entry = map->emplace(key, ConfigItem());
+        if(entry.second) {
+          entry.first->second.setParent(map);
+          entry.first->second.setLazy(it->second);
+        }
+      }
+      self.setNode(map);
+    } else {
+      ConfigVector *vector = new ConfigVector();
+      vector->reserve(n.size());
+      for(const YAML::Node &child : n) {
+        vector->emplace_back().setLazy(child);
+      }
+      self.setNode(vector);
+    }
+    // no references into the new node are handed out yet
+    self.container()->setShareable(true);
+  }
+
+  ConfigItem ConfigItem::fromYamlNodeLazy(const YAML::Node &n) {
+    ConfigItem root;
+    root.setLazy(n);
+    return root;
+  }
+
+  ConfigItem ConfigItem::fromYamlStringLazy(const std::string &s) {
+    return fromYamlNodeLazy(YAML::Load(s));
+  }
+
+  ConfigItem ConfigItem::fromYamlFileLazy(const std::string &filename) {
+    std::ifstream fin(filename.c_str());
+    if(fin.fail()){
+      throw std::runtime_error("Failed to open File: " + filename);
+    }
+    return fromYamlNodeLazy(YAML::Load(fin));
   }
 
+  namespace {
+
+    /**
+     * @brief Builds a ConfigItem tree from the events of YAML::Parser.
+     *
+     * The items are created while parsing, no YAML::Node graph is built
+     * in between. Like the YAML::Node constructors, null map values are
+     * skipped and the first of duplicate keys wins.
+     */
+    class YamlItemBuilder : public YAML::EventHandler {
+    public:
+      explicit YamlItemBuilder(ConfigItem &root) : root(root), hasRoot(false) {}
+
+      virtual void OnDocumentStart(const YAML::Mark&) override {}
+      virtual void OnDocumentEnd() override {}
+
+      virtual void OnNull(const YAML::Mark &mark, YAML::anchor_t anchor) override {
+        remember(anchor, ConfigItem());
+        if(expectsKey()) {
+          throw YAML::ParserException(mark, "ConfigMap keys have to be scalars");
+        }
+        if(!stack.empty() && stack.back().isMap) {
+          stack.back().hasKey = false;
+          return;
+        }
+        if(!stack.empty()) {
+          throw YAML::ParserException(mark, "Could not create ConfigItem from null value");
+        }
+        // a null document leaves the root empty
+        hasRoot = true;
+      }
+
+      virtual void OnAlias(const YAML::Mark &mark, YAML::anchor_t anchor) override {
+        if(anchor >= anchors.size()) {
+          throw YAML::ParserException(mark, "Unknown YAML alias");
+        }
+        const ConfigItem &anchored = anchors[anchor];
+        if(!anchored.getNode()) {
+          OnNull(mark, YAML::NullAnchor);
+        } else if(expectsKey()) {
+          if(!anchored.isAtom()) {
+            throw YAML::ParserException(mark, "ConfigMap keys have to be scalars");
+          }
+          setKey(anchored.toString());
+        } else {
+          nextSlot(mark) = anchored;
+        }
+      }
+
+      virtual void OnScalar(const YAML::Mark &mark, const std::string &tag,
+                            YAML::anchor_t anchor,
+                            const std::string &value) override {
+        if(expectsKey()) {
+          setKey(value);
+          return;
+        }
+        ConfigItem &item = nextSlot(mark);
+        // the non-specific tag "!" marks quoted scalars
+        if(tag == "!") {
+          item.getOrCreateAtom()->setQuotedString(value);
+        } else {
+          item.getOrCreateAtom()->setUnparsedString(value);
+        }
+        if(ConfigBase::debugLevel >= 1) {
+          fprintf(stderr, " %s", value.c_str());
+        }
+        remember(anchor, item);
+      }
+
+      virtual void OnSequenceStart(const YAML::Mark &mark, const std::string&,
+                                   YAML::anchor_t anchor,
+                                   YAML::EmitterStyle::value) override {
+        ConfigItem &item = nextSlot(mark);
+        stack.push_back(Frame(&item, (ConfigVector*)item, anchor));
+      }
+
+      virtual void OnSequenceEnd() override {
+        endContainer();
+      }
+
+      virtual void OnMapStart(const YAML::Mark &mark, const std::string&,
+                              YAML::anchor_t anchor,
+                              YAML::EmitterStyle::value) override {
+        ConfigItem &item = nextSlot(mark);
+        stack.push_back(Frame(&item, (ConfigMap*)item, anchor));
+      }
+
+      virtual void OnMapEnd() override {
+        endContainer();
+      }
+
+    private:
+      struct Frame {
+        Frame(ConfigItem *i, ConfigMap *m, YAML::anchor_t a)
+          : item(i), node(m), anchor(a), isMap(true), hasKey(false) {}
+        Frame(ConfigItem *i, ConfigVector *v, YAML::anchor_t a)
+          : item(i), node(v), anchor(a), isMap(false), hasKey(false) {}
+
+        ConfigItem *item;
+        ConfigContainer *node;
+        YAML::anchor_t anchor;
+        bool isMap;
+        bool hasKey;
+        std::string key;
+      };
+
+      ConfigItem &root;
+      bool hasRoot;
+      std::vector<Frame> stack;
+      std::vector<ConfigItem> anchors;
+      // values of duplicate keys, std::list keeps them in place while
+      // they are filled
+      std::list<ConfigItem> discarded;
+
+      bool expectsKey() const {
+        return !stack.empty() && stack.back().isMap && !stack.back().hasKey;
+      }
+
+      void setKey(const std::string &key) {
+        stack.back().key = key;
+        stack.back().hasKey = true;
+        if(ConfigBase::debugLevel >= 1) {
+          fprintf(stderr, "\n%s:", key.c_str());
+        }
+      }
+
+      // Returns the item that takes the next value.
+      ConfigItem& nextSlot(const YAML::Mark &mark) {
+        if(stack.empty()) {
+          if(hasRoot) {
+            throw YAML::ParserException(mark, "Unexpected YAML value after the root");
+          }
+          hasRoot = true;
+          return root;
+        }
+        Frame &frame = stack.back();
+        if(frame.isMap) {
+          frame.hasKey = false;
+          ConfigMap *map = static_cast<ConfigMap*>(frame.node);
+          std::pair<ConfigMap::iterator, bool> it = map->try_emplace(std::move(frame.key));
+          if(!it.second) {
+            discarded.emplace_back();
+            return discarded.back();
+          }
+          it.first->second.setParent(map);
+          return it.first->second;
+        }
+        ConfigVector *vector = static_cast<ConfigVector*>(frame.node);
+        vector->append(ConfigItem());
+        return vector->back();
+      }
+
+      void endContainer() {
+        Frame frame = std::move(stack.back());
+        stack.pop_back();
+        // the builder is done with the node, copies may share it now
+        frame.node->setShareable(true);
+        remember(frame.anchor, *frame.item);
+      }
+
+      void remember(YAML::anchor_t anchor, const ConfigItem &item) {
+        if(anchor == YAML::NullAnchor) {
+          return;
+        }
+        if(anchors.size() <= anchor) {
+          anchors.resize(anchor + 1);
+        }
+        anchors[anchor] = item;
+      }
+    }; // end of class YamlItemBuilder
+
+    // Finds the next '"' or '\\' of a JSON string, 16 characters at a time
+    // where SSE2 is available.
+    inline const char* findStringStop(const char *p, const char *end) {
+#ifdef __SSE2__
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i backslash = _mm_set1_epi8('\\');
+      while(end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                  _mm_cmpeq_epi8(chunk, backslash)));
+        if(mask) {
+          return p + __builtin_ctz(mask);
+        }
+        p += 16;
+      }
+#endif
+      while(p != end && *p != '"' && *p != '\\') {
+        ++p;
+      }
+      return p;
+    }
+
+    /*
+     * Reads a JSON text straight into ConfigItems. It accepts what the
+     * jsoncpp reader accepted before: comments, any value as root and
+     * duplicate keys of which the last one wins. Numbers and booleans are
+     * stored as inferred typed atoms, strings stay unparsed and null values
+     * of objects are skipped.
+     */
+    class JsonItemReader {
+    public:
+      JsonItemReader(const char *begin, const char *end)
+        : begin(begin), pos(begin), end(end) {}
+
+      void read(ConfigItem &root) {
+        skipSpace();
+        if(pos == end) {
+          fail("Empty JSON document");
+        }
+        readValue(root, 0);
+        skipSpace();
+        if(pos != end) {
+          fail("Unexpected text after the JSON root value");
+        }
+      }
+
+    private:
+      static const int MAX_DEPTH = 1000;
+
+      const char *begin;
+      const char *pos;
+      const char *end;
+      // the last string read
+      std::string text;
+
+      [[noreturn]] void fail(const char *message) const {
+        int line = 1;
+        const char *lineStart = begin;
+        for(const char *p = begin; p != pos; ++p) {
+          if(*p == '\n') {
+            ++line;
+            lineStart = p + 1;
+          }
+        }
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "JSON parse error at line %d, column %d: ",
+                 line, (int)(pos - lineStart) + 1);
+        throw std::runtime_error(buffer + std::string(message));
+      }
+
+      void skipSpace() {
+        while(pos != end) {
+          switch(*pos) {
+          case ' ': case '\t': case '\n': case '\r':
+            ++pos;
+            break;
+          case '/':
+            skipComment();
+            break;
+          default:
+            return;
+          }
+        }
+      }
+
+      void skipComment() {
+        if(end - pos < 2 || (pos[1] != '/' && pos[1] != '*')) {
+          fail("Unexpected '/'");
+        }
+        if(pos[1] == '/') {
+          const char *lineEnd = (const char*)memchr(pos, '\n', end - pos);
+          pos = lineEnd ? lineEnd + 1 : end;
+          return;
+        }
+        for(const char *p = pos + 2; p + 1 < end; ++p) {
+          if(p[0] == '*' && p[1] == '/') {
+            pos = p + 2;
+            return;
+          }
+        }
+        fail("Unterminated comment");
+      }
+
+      void expect(char c, const char *message) {
+        skipSpace();
+        if(pos == end || *pos != c) {
+          fail(message);
+        }
+        ++pos;
+        skipSpace();
+      }
+
+      bool readLiteral(const char *literal, size_t length) {
+        if((size_t)(end - pos) < length || memcmp(pos, literal, length)) {
+          return false;
+        }
+        pos += length;
+        return true;
+      }
+
+      void readValue(ConfigItem &item, int depth) {
+        if(pos == end) {
+          fail("Unexpected end of JSON document");
+        }
+        switch(*pos) {
+        case '{':
+          readObject(item, depth + 1);
+          break;
+        case '[':
+          readArray(item, depth + 1);
+          break;
+        case '"':
+          readString();
+          item = text;
+          break;
+        case 't':
+        case 'f': {
+          bool value = *pos == 't';
+          if(!(value ? readLiteral("true", 4) : readLiteral("false", 5))) {
+            fail("Invalid JSON value");
+          }
+          ConfigAtom *atom = item.getOrCreateAtom();
+          atom->setBool(value);
+          atom->markInferred();
+          break;
+        }
+        case 'n':
+          // jsoncpp read null values as empty strings
+          if(!readLiteral("null", 4)) {
+            fail("Invalid JSON value");
+          }
+          item = "";
+          break;
+        default:
+          readNumber(item);
+          break;
+        }
+      }
+
+      void readObject(ConfigItem &item, int depth) {
+        if(depth > MAX_DEPTH) {
+          fail("JSON document is nested too deeply");
+        }
+        ConfigMap *map = item;
+        ++pos;
+        skipSpace();
+        if(pos != end && *pos == '}') {
+          ++pos;
+          map->setShareable(true);
+          return;
+        }
+        while(true) {
+          if(pos == end || *pos != '"') {
+            fail("Expected a string as JSON object key");
+          }
+          readString();
+          expect(':', "Expected ':' after JSON object key");
+          if(readLiteral("null", 4)) {
+            map->erase(text);
+          } else {
+            std::pair<ConfigMap::iterator, bool> it = map->try_emplace(text);
+            ConfigItem &child = it.first->second;
+            if(it.second) {
+              child.setParent(map);
+            } else {
+              child = ConfigItem();
+            }
+            readValue(child, depth);
+          }
+          skipSpace();
+          if(pos != end && *pos == ',') {
+            ++pos;
+            skipSpace();
+          } else if(pos != end && *pos == '}') {
+            ++pos;
+            map->setShareable(true);
+            return;
+          } else {
+            fail("Expected ',' or '}' in JSON object");
+          }
+        }
+      }
+
+      void readArray(ConfigItem &item, int depth) {
+        if(depth > MAX_DEPTH) {
+          fail("JSON document is nested too deeply");
+        }
+        ConfigVector *vector = item;
+        ++pos;
+        skipSpace();
+        if(pos != end && *pos == ']') {
+          ++pos;
+          vector->setShareable(true);
+          return;
+        }
+        while(true) {
+          vector->append(ConfigItem());
+          readValue(vector->back(), depth);
+          skipSpace();
+          if(pos != end && *pos == ',') {
+            ++pos;
+            skipSpace();
+          } else if(pos != end && *pos == ']') {
+            ++pos;
+            vector->setShareable(true);
+            return;
+          } else {
+            fail("Expected ',' or ']' in JSON array");
+          }
+        }
+      }
+
+      void readString() {
+        ++pos;
+        text.clear();
+        while(true) {
+          const char *stop = findStringStop(pos, end);
+          text.append(pos, stop);
+          pos = stop;
+          if(pos == end) {
+            fail("Unterminated JSON string");
+          }
+          if(*pos++ == '"') {
+            return;
+          }
+          readEscape();
+        }
+      }
+
+      void readEscape() {
+        if(pos == end) {
+          fail("Unterminated JSON string");
+        }
+        switch(*pos++) {
+        case '"': text += '"'; break;
+        case '\\': text += '\\'; break;
+        case '/': text += '/'; break;
+        case 'b': text += '\b'; break;
+        case 'f': text += '\f'; break;
+        case 'n': text += '\n'; break;
+        case 'r': text += '\r'; break;
+        case 't': text += '\t'; break;
+        case 'u':
+          appendUtf8(readCodePoint());
+          break;
+        default:
+          --pos;
+          fail("Invalid escape sequence in JSON string");
+        }
+      }
+
+      unsigned int readHex() {
+        if(end - pos < 4) {
+          fail("Invalid unicode escape in JSON string");
+        }
+        unsigned int value;
+        std::from_chars_result r = std::from_chars(pos, pos + 4, value, 16);
+        if(r.ec != std::errc() || r.ptr != pos + 4) {
+          fail("Invalid unicode escape in JSON string");
+        }
+        pos += 4;
+        return value;
+      }
+
+      unsigned int readCodePoint() {
+        unsigned int value = readHex();
+        if(value >= 0xDC00 && value <= 0xDFFF) {
+          fail("Unpaired surrogate in JSON string");
+        }
+        if(value >= 0xD800 && value <= 0xDBFF) {
+          if(!readLiteral("\\u", 2)) {
+            fail("Unpaired surrogate in JSON string");
+          }
+          unsigned int low = readHex();
+          if(low < 0xDC00 || low > 0xDFFF) {
+            fail("Unpaired surrogate in JSON string");
+          }
+          value = 0x10000 + ((value - 0xD800) << 10) + (low - 0xDC00);
+        }
+        return value;
+      }
+
+      void appendUtf8(unsigned int c) {
+        if(c < 0x80) {
+          text += (char)c;
+        } else if(c < 0x800) {
+          text += (char)(0xC0 | (c >> 6));
+          text += (char)(0x80 | (c & 0x3F));
+        } else if(c < 0x10000) {
+          text += (char)(0xE0 | (c >> 12));
+          text += (char)(0x80 | ((c >> 6) & 0x3F));
+          text += (char)(0x80 | (c & 0x3F));
+        } else {
+          text += (char)(0xF0 | (c >> 18));
+          text += (char)(0x80 | ((c >> 12) & 0x3F));
+          text += (char)(0x80 | ((c >> 6) & 0x3F));
+          text += (char)(0x80 | (c & 0x3F));
+        }
+      }
+
+      bool skipDigits() {
+        const char *first = pos;
+        while(pos != end && *pos >= '0' && *pos <= '9') {
+          ++pos;
+        }
+        return pos != first;
+      }
+
+      // Integers become int atoms or unsigned long atoms if they do not
+      // fit, everything else is stored as double. Integers beyond both
+      // ranges keep their text, a double would round them. "-0" is read
+      // as double to keep the sign.
+      void readNumber(ConfigItem &item) {
+        const char *first = pos;
+        if(*pos == '-') {
+          ++pos;
+        }
+        if(pos == end || *pos < '0' || *pos > '9') {
+          fail("Invalid JSON value");
+        }
+        if(*pos == '0') {
+          ++pos;
+        } else {
+          skipDigits();
+        }
+        bool integral = true;
+        if(pos != end && *pos == '.') {
+          ++pos;
+          integral = false;
+          if(!skipDigits()) {
+            fail("Invalid JSON number");
+          }
+        }
+        if(pos != end && (*pos == 'e' || *pos == 'E')) {
+          ++pos;
+          integral = false;
+          if(pos != end && (*pos == '+' || *pos == '-')) {
+            ++pos;
+          }
+          if(!skipDigits()) {
+            fail("Invalid JSON number");
+          }
+        }
+        ConfigAtom *atom = item.getOrCreateAtom();
+        if(integral && !(pos - first == 2 && *first == '-' && first[1] == '0')) {
+          int i;
+          unsigned long lu;
+          if(std::from_chars(first, pos, i).ec == std::errc()) {
+            atom->setInt(i);
+            atom->markInferred();
+            return;
+          }
+          if(*first != '-' && std::from_chars(first, pos, lu).ec == std::errc()) {
+            atom->setULong(lu);
+            atom->markInferred();
+            return;
+          }
+          atom->setUnparsedString(std::string(first, pos));
+          return;
+        }
+        // subnormal and huge values are read as denormal, zero or infinity
+        double d;
+        if(ConfigAtom::parseDouble(first, pos, d).ec != std::errc()) {
+          fail("Invalid JSON number");
+        }
+        atom->setDouble(d);
+        atom->markInferred();
+      }
+    }; // end of class JsonItemReader
+
+  } // end of anonymous namespace
+
   ConfigItem ConfigItem::fromYamlStream(std::istream &in) {
-    YAML::Node node = YAML::Load(in);
-    return ConfigItem(node);
+    ConfigItem root;
+    YamlItemBuilder builder(root);
+    YAML::Parser parser(in);
+    parser.HandleNextDocument(builder);
+    if(!root.item) {
+      throw std::runtime_error("Could not create ConfigItem from empty or null YAML document!");
+    }
+    return root;
+  }
+
+  namespace {
+
+    // settings of the cache of fromYamlFile
+    bool yamlCacheEnabled = false;
+    std::string yamlCacheDirectory;
+
+    const char YAML_CACHE_MAGIC[4] = {'C', 'M', 'C', 1};
+
+    // FNV-1a, the cache only has to notice changed files
+    uint64_t hashContent(std::string_view data) {
+      uint64_t hash = 14695981039346656037ull;
+      for(unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ull;
+      }
+      return hash;
+    }
+
+    bool readFile(const std::string &filename, std::string &content) {
+      std::ifstream fin(filename.c_str(), std::ios::binary);
+      if(fin.fail()) {
+        return false;
+      }
+      content.assign(std::istreambuf_iterator<char>(fin),
+                     std::istreambuf_iterator<char>());
+      return !fin.bad();
+    }
+
+    std::string yamlCachePath(const std::string &filename, bool loadURI) {
+      const char *suffix = loadURI ? ".uri.cmb" : ".cmb";
+      if(yamlCacheDirectory.empty()) {
+        return filename + suffix;
+      }
+      std::string absolute =
+        std::filesystem::absolute(filename).lexically_normal().string();
+      char name[17];
+      snprintf(name, sizeof(name), "%016llx",
+               (unsigned long long)hashContent(absolute));
+      return yamlCacheDirectory + "/" + name + suffix;
+    }
+
+    void putFixed(std::string &out, uint64_t value) {
+      for(int i = 0; i < 8; ++i) {
+        out += (char)(value >> (8 * i));
+      }
+    }
+
+    /*
+     * Layout: magic, uint64 file count, per file its path length, path,
+     * size and hash, then the binary document. Returns false if the cache
+     * is missing, broken or outdated.
+     */
+    bool readYamlCache(const std::string &cachePath, ConfigItem &item) {
+      std::string data, content;
+      if(!readFile(cachePath, data) || data.size() < 4 ||
+         memcmp(data.data(), YAML_CACHE_MAGIC, 4)) {
+        return false;
+      }
+      try {
+        const char *pos = data.data() + 4;
+        const char *end = data.data() + data.size();
+        uint64_t count = ConfigBinaryReader::readFixed(pos, end, 8);
+        for(uint64_t i = 0; i < count; ++i) {
+          uint64_t length = ConfigBinaryReader::readFixed(pos, end, 8);
+          if(length > (uint64_t)(end - pos)) {
+            return false;
+          }
+          std::string path(pos, length);
+          pos += length;
+          uint64_t size = ConfigBinaryReader::readFixed(pos, end, 8);
+          uint64_t hash = ConfigBinaryReader::readFixed(pos, end, 8);
+          if(!readFile(path, content) || content.size() != size ||
+             hashContent(content) != hash) {
+            return false;
+          }
+        }
+        item = ConfigItem::fromBinary(pos, end - pos);
+        return true;
+      } catch(const std::runtime_error&) {
+        return false;
+      }
+    }
+
+    void putLoadedFile(std::string &data, const std::string &path,
+                       uint64_t size, uint64_t hash) {
+      putFixed(data, path.size());
+      data += path;
+      putFixed(data, size);
+      putFixed(data, hash);
+    }
+
+    // data holds the file list, the document is appended
+    void writeYamlCache(const std::string &cachePath, std::string data,
+                        const ConfigItem &item) {
+      data += item.toBinary();
+      // written under a temporary name and renamed, so that other
+      // processes never read a partial cache
+      std::string tmp = cachePath + ".tmp" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+      std::ofstream f(tmp.c_str(), std::ios::binary);
+      if(!f.good()) {
+        if(ConfigBase::debugLevel >= 1) {
+          fprintf(stderr, "could not write YAML cache: %s\n", cachePath.c_str());
+        }
+        return;
+      }
+      f.write(data.data(), data.size());
+      f.close();
+      if(f.fail() || std::rename(tmp.c_str(), cachePath.c_str())) {
+        std::remove(tmp.c_str());
+      }
+    }
+
+    // rough heap size of a tree for the budget of the parsed file cache
+    size_t treeBytes(const ConfigItem &item) {
+      size_t bytes = sizeof(ConfigItem);
+      if(item.isMap()) {
+        const ConfigMap &map = static_cast<const ConfigMap&>(
+          (const ConfigBase&)item);
+        bytes += sizeof(ConfigMap);
+        for(const auto &it : map) {
+          // key and index entry of the FIFOMap
+          bytes += it.first.capacity() + 4 * sizeof(void*) + treeBytes(it.second);
+        }
+      } else if(item.isVector()) {
+        const ConfigVector &vector = static_cast<const ConfigVector&>(
+          (const ConfigBase&)item);
+        bytes += sizeof(ConfigVector);
+        for(const ConfigItem &child : vector) {
+          bytes += treeBytes(child);
+        }
+      } else if(item.isAtom()) {
+        bytes += item.toString().size();
+      }
+      return bytes;
+    }
+
+    /**
+     * @brief Process wide cache of the trees parsed from YAML files.
+     *
+     * Entries are keyed by the canonical path and only used while the
+     * modification time and size of the file match. The least recently
+     * used entries are dropped when the trees exceed the budget.
+     */
+    class ParsedFileCache {
+    public:
+      struct Stat {
+        std::string path;
+        std::filesystem::file_time_type mtime;
+        uint64_t size;
+      };
+
+      bool isEnabled() const {
+        return budget.load(std::memory_order_relaxed) > 0;
+      }
+
+      void setBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = bytes;
+        evict();
+      }
+
+      static bool stat(const std::string &filename, Stat &stat) {
+        std::error_code ec;
+        stat.path = std::filesystem::canonical(filename, ec).string();
+        if(ec) return false;
+        stat.mtime = std::filesystem::last_write_time(stat.path, ec);
+        if(ec) return false;
+        stat.size = std::filesystem::file_size(stat.path, ec);
+        return !ec;
+      }
+
+      // copies the cached tree into item
+      bool find(const Stat &stat, ConfigItem &item, uint64_t &hash) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(stat.path);
+        if(it == entries.end()) {
+          return false;
+        }
+        Entry &entry = it->second;
+        if(entry.mtime != stat.mtime || entry.size != stat.size) {
+          drop(it);
+          return false;
+        }
+        lru.splice(lru.begin(), lru, entry.lru);
+        item = entry.item;
+        hash = entry.hash;
+        return true;
+      }
+
+      void insert(const Stat &stat, uint64_t hash, const ConfigItem &item) {
+        size_t bytes = treeBytes(item) + stat.path.size();
+        std::lock_guard<std::mutex> lock(mutex);
+        if(bytes > budget) {
+          return;
+        }
+        auto it = entries.find(stat.path);
+        if(it != entries.end()) {
+          drop(it);
+        }
+        lru.push_front(stat.path);
+        entries.emplace(stat.path, Entry{stat.mtime, stat.size, hash, item,
+                                         bytes, lru.begin()});
+        used += bytes;
+        evict();
+      }
+
+    private:
+      struct Entry {
+        std::filesystem::file_time_type mtime;
+        uint64_t size;
+        uint64_t hash;
+        ConfigItem item;
+        size_t bytes;
+        std::list<std::string>::iterator lru;
+      };
+
+      std::mutex mutex;
+      std::atomic<size_t> budget{0};
+      size_t used = 0;
+      // most recently used path first
+      std::list<std::string> lru;
+      std::unordered_map<std::string, Entry> entries;
+
+      void drop(std::unordered_map<std::string, Entry>::iterator it) {
+        used -= it->second.bytes;
+        lru.erase(it->second.lru);
+        entries.erase(it);
+      }
+
+      void evict() {
+        while(used > budget && !lru.empty()) {
+          drop(entries.find(lru.back()));
+        }
+      }
+    };
+
+    ParsedFileCache parsedFileCache;
+
+  } // end of anonymous namespace
+
+  void ConfigItem::enableYamlCache(const std::string &directory) {
+    yamlCacheDirectory = directory;
+    yamlCacheEnabled = true;
+  }
+
+  void ConfigItem::disableYamlCache() {
+    yamlCacheEnabled = false;
+  }
+
+  void ConfigItem::enableParsedFileCache(size_t budget) {
+    parsedFileCache.setBudget(budget);
+  }
+
+  void ConfigItem::disableParsedFileCache() {
+    parsedFileCache.setBudget(0);
   }
 
   ConfigItem ConfigItem::fromYamlFile(const std::string &filename, bool loadURI) {
+    if(!yamlCacheEnabled) {
+      return loadYamlFile(filename, loadURI, NULL);
+    }
+    std::string cachePath = yamlCachePath(filename, loadURI);
+    ConfigItem retVal;
+    if(readYamlCache(cachePath, retVal)) {
+      if(ConfigBase::debugLevel >= 1) {
+        fprintf(stderr, "loaded %s from cache %s\n", filename.c_str(),
+                cachePath.c_str());
+      }
+      return retVal;
+    }
+    std::vector<LoadedFile> files;
+    retVal = loadYamlFile(filename, loadURI, &files);
+    std::string data(YAML_CACHE_MAGIC, 4);
+    putFixed(data, files.size());
+    for(const LoadedFile &file : files) {
+      putLoadedFile(data, file.path, file.size, file.hash);
+    }
+    writeYamlCache(cachePath, std::move(data), retVal);
+    return retVal;
+  }
+
+  // Records the read files with their hash if files is set.
+  ConfigItem ConfigItem::parseYamlFile(const std::string &filename,
+                                       LoadedFile *record) {
+    ParsedFileCache::Stat stat;
+    bool cached = parsedFileCache.isEnabled() &&
+      ParsedFileCache::stat(filename, stat);
+    if(cached) {
+      ConfigItem item;
+      uint64_t hash;
+      if(parsedFileCache.find(stat, item, hash)) {
+        if(record) {
+          *record = LoadedFile{filename, stat.size, hash};
+        }
+        return item;
+      }
+    }
+    if(record || cached) {
+      std::string content;
+      if(!readFile(filename, content)) {
+        throw std::runtime_error("Failed to open File: " + filename);
+      }
+      uint64_t hash = hashContent(content);
+      if(record) {
+        *record = LoadedFile{filename, content.size(), hash};
+      }
+      std::istringstream sin(content);
+      ConfigItem item = fromYamlStream(sin);
+      // the file might have changed after stat()
+      if(cached && content.size() == stat.size) {
+        parsedFileCache.insert(stat, hash, item);
+      }
+      return item;
+    }
     std::ifstream fin(filename.c_str());
     if(fin.fail()){
       throw std::runtime_error("Failed to open File: " + filename);
     }
+    return fromYamlStream(fin);
+  }
 
-    ConfigItem retVal = fromYamlStream(fin);
+  ConfigItem ConfigItem::loadYamlFile(const std::string &filename, bool loadURI,
+                                      std::vector<LoadedFile> *files) {
+    LoadedFile record;
+    ConfigItem retVal = parseYamlFile(filename, files ? &record : NULL);
+    if(files) {
+      files->push_back(std::move(record));
+    }
 
     if(loadURI) {
       std::string pathToFile = getPathOfFile(filename);
-      recursiveLoad(retVal, pathToFile);
+      recursiveLoad(retVal, pathToFile, files);
     }
     return retVal;
   }
@@ -172,14 +1382,40 @@ namespace configmaps {
   }
 
   ConfigItem ConfigItem::fromJsonStream(std::istream &in) {
-    Json::Value v;
-    in >> v;
-    return ConfigItem(v);
+    std::string s((std::istreambuf_iterator<char>(in)),
+                  std::istreambuf_iterator<char>());
+    return fromJsonString(s);
   }
 
   ConfigItem ConfigItem::fromJsonString(const std::string &s) {
-    std::istringstream sin(s);
-    return fromJsonStream(sin);
+    ConfigItem root;
+    JsonItemReader reader(s.data(), s.data() + s.size());
+    reader.read(root);
+    return root;
+  }
+
+  ConfigItem ConfigItem::fromBinary(const char *data, size_t size) {
+    ConfigItem root;
+    ConfigBinaryReader reader(data, size);
+    reader.read(root);
+    if(!root.item) {
+      throw std::runtime_error("Could not create ConfigItem from empty binary document!");
+    }
+    return root;
+  }
+
+  ConfigItem ConfigItem::fromBinary(const std::string &data) {
+    return fromBinary(data.data(), data.size());
+  }
+
+  ConfigItem ConfigItem::fromBinaryFile(const std::string &filename) {
+    std::ifstream fin(filename.c_str(), std::ios::binary);
+    if(fin.fail()){
+      throw std::runtime_error("Failed to open File: " + filename);
+    }
+    std::string data((std::istreambuf_iterator<char>(fin)),
+                     std::istreambuf_iterator<char>());
+    return fromBinary(data);
   }
 
   std::vector<ConfigItem>::iterator ConfigItem::begin() {
@@ -191,11 +1427,12 @@ namespace configmaps {
   }
 
   FIFOMap<std::string, ConfigItem>::iterator ConfigItem::beginMap() {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
       return v->begin();
     }
@@ -203,79 +1440,114 @@ namespace configmaps {
   }
 
   FIFOMap<std::string, ConfigItem>::iterator ConfigItem::endMap() {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
       return v->end();
     }
-    fprintf(stderr, "(endMap) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(endMap) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
-  FIFOMap<std::string, ConfigItem>::iterator ConfigItem::find(std::string key) {
+  FIFOMap<std::string, ConfigItem>::iterator ConfigItem::find(std::string_view key) {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
       return v->find(key);
     }
-    fprintf(stderr, "(map::find) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map::find) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
-  bool ConfigItem::hasKey(std::string key) {
+  bool ConfigItem::hasKey(std::string_view key) {
     return (find(key) != endMap());
   }
 
   void ConfigItem::appendMap(const ConfigMap &value) {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
       v->append(value);
       return;
     }
-    fprintf(stderr, "(map::appendMap) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map::appendMap) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
+  }
+
+  void ConfigItem::appendMap(ConfigMap &&value) {
+    detach();
+    if(!item) {
+      item = new ConfigMap();
+      item->setParent(parent);
+    }
+    ConfigMap *v = asMap(item);
+    if(v) {
+      v->append(std::move(value));
+      return;
+    }
+    fprintf(stderr, "(map::appendMap) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   void ConfigItem::updateMap(const ConfigMap &update) {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
-      ConfigMap map = update;
-      v->updateMap(map);
+      v->updateMap(update);
       return;
     }
-    fprintf(stderr, "(map::updateMap) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map::updateMap) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
+  }
+
+  void ConfigItem::updateMap(ConfigMap &&update) {
+    detach();
+    if(!item) {
+      item = new ConfigMap();
+      item->setParent(parent);
+    }
+    ConfigMap *v = asMap(item);
+    if(v) {
+      v->updateMap(std::move(update));
+      return;
+    }
+    fprintf(stderr, "(map::updateMap) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   void ConfigItem::erase(FIFOMap<std::string, ConfigItem>::iterator &it) {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *v = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *v = asMap(item);
     if(v) {
       v->erase(it);
       return;
     }
-    fprintf(stderr, "(map::erase) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map::erase) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   void ConfigItem::dumpToYamlEmitter(YAML::Emitter &emitter) const {
+    resolve();
     if(!item){
       throw std::runtime_error("Item not set while toYamlStream was requested!");
     }
@@ -283,26 +1555,35 @@ namespace configmaps {
   }
 
   void ConfigItem::toYamlStream(std::ostream &out) const {
-    YAML::Emitter emitter;
-    dumpToYamlEmitter(emitter);
-    if(!emitter.good()) {
-      fprintf(stderr, "ERROR: ConfigMap::toYamlStream failed!\n");
-      return;
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toYamlStream was requested!");
     }
-    out << emitter.c_str() << std::endl;
+    item->toYamlStream(out);
   }
 
   void ConfigItem::dumpToJsonValue(Json::Value &root) const{
+    resolve();
     if(!item){
       throw std::runtime_error("Item not set while toYamlStream was requested!");
     }
     item->dumpToJsonValue(root);
   }
 
-  void ConfigItem::toJsonStream(std::ostream &out) const {
-    Json::Value root;
-    dumpToJsonValue(root);
-    out << root.toStyledString() << std::endl;
+  void ConfigItem::dumpToJsonWriter(ConfigJsonWriter &writer) const {
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toJsonStream was requested!");
+    }
+    item->dumpToJsonWriter(writer);
+  }
+
+  void ConfigItem::toJsonStream(std::ostream &out, bool pretty) const {
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toJsonStream was requested!");
+    }
+    item->toJsonStream(out, pretty);
   }
 
   void ConfigItem::toYamlFile(const std::string &filename) const {
@@ -322,78 +1603,85 @@ namespace configmaps {
     return sout.str();
   }
 
-  std::string ConfigItem::toJsonString() const {
-    std::ostringstream sout;
-    toJsonStream(sout);
-    return sout.str();
+  void ConfigItem::dumpToBinaryWriter(ConfigBinaryWriter &writer) const {
+    resolve();
+    if(!item) {
+      writer.writeEmpty();
+      return;
+    }
+    item->dumpToBinaryWriter(writer);
   }
 
-  bool ConfigItem::isAtom() const {
-    if(item) {
-      ConfigAtom *m = dynamic_cast<ConfigAtom*>(item);
-      if(m) return true;
+  std::string ConfigItem::toBinary() const {
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toBinary was requested!");
     }
-    return false;
+    return item->toBinary();
   }
 
-  bool ConfigItem::isMap() const {
-    if(item) {
-      ConfigMap *m = dynamic_cast<ConfigMap*>(item);
-      if(m) return true;
+  void ConfigItem::toBinaryFile(const std::string &filename) const {
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toBinaryFile was requested!");
     }
-    return false;
+    item->toBinaryFile(filename);
   }
 
-  bool ConfigItem::isVector() const {
-    if(item) {
-      ConfigVector *m = dynamic_cast<ConfigVector*>(item);
-      if(m) return true;
+  std::string ConfigItem::toJsonString(bool pretty) const {
+    resolve();
+    if(!item){
+      throw std::runtime_error("Item not set while toJsonStream was requested!");
     }
-    return false;
+    return item->toJsonString(pretty);
   }
 
   ConfigItem::operator ConfigMap& () {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *m = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *m = asMap(item);
     if(m) return *m;
-    fprintf(stderr, "(map&) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map&) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   ConfigItem::operator ConfigMap& () const {
+    const_cast<ConfigItem*>(this)->detach();
     if(!item) {
-      fprintf(stderr, "(map&) parent: %s\n", parentName.c_str());
-      throw wrongTypeExp;
+      fprintf(stderr, "(map&) path: %s\n", getPath().c_str());
+      throw WrongTypeException();
     }
-    ConfigMap *m = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *m = asMap(item);
     if(m) return *m;
-    fprintf(stderr, "(map&) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map&) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   ConfigItem::operator ConfigMap* () {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
+      item->setParent(parent);
     }
-    ConfigMap *m = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *m = asMap(item);
     if(m) return m;
-    fprintf(stderr, "(map*) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map*) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   ConfigItem::operator ConfigMap* () const {
+    const_cast<ConfigItem*>(this)->detach();
     if(!item) {
-      fprintf(stderr, "(map&) parent: %s\n", parentName.c_str());
-      throw wrongTypeExp;
+      fprintf(stderr, "(map&) path: %s\n", getPath().c_str());
+      throw WrongTypeException();
     }
-    ConfigMap *m = dynamic_cast<ConfigMap*>(item);
+    ConfigMap *m = asMap(item);
     if(m) return m;
-    fprintf(stderr, "(map*) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "(map*) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   ConfigItem::operator ConfigVector& () {
@@ -457,7 +1745,7 @@ namespace configmaps {
   }
 
   ConfigItem& ConfigItem::operator=(const std::string &v) {
-    getOrCreateAtom()->setUnparsedString(v);
+    getOrCreateAtom()->setQuotedString(v);
     return *this;
   }
 
@@ -470,7 +1758,7 @@ namespace configmaps {
   }
 
   ConfigItem& ConfigItem::operator=(const char *v) {
-    getOrCreateAtom()->setUnparsedString(v);
+    getOrCreateAtom()->setQuotedString(v);
     return *this;
   }
 
@@ -480,28 +1768,33 @@ namespace configmaps {
   }
 
   ConfigItem& ConfigItem::operator[](const char* s) {
-    return (*this)[std::string(s)];
+    return (*this)[std::string_view(s)];
+  }
+
+  ConfigItem& ConfigItem::operator[](const std::string &s) {
+    return (*this)[std::string_view(s)];
   }
 
-  ConfigItem& ConfigItem::operator[](std::string s) {
+  ConfigItem& ConfigItem::operator[](std::string_view s) {
+    detach();
     if(!item) {
       item = new ConfigMap();
-      item->setParentName(parentName);
-    }
-    ConfigMap *m = dynamic_cast<ConfigMap*>(item);
-    if(m) {
-      return (*m)[s];
+      item->setParent(parent);
     }
-    ConfigVector *v = dynamic_cast<ConfigVector*>(item);
-    if(v) {
-      return (*v)[0][s];
+    switch(item->getNodeType()) {
+    case ConfigBase::MAP_NODE:
+      return (*static_cast<ConfigMap*>(item))[s];
+    case ConfigBase::VECTOR_NODE:
+      return (*static_cast<ConfigVector*>(item))[0][s];
+    default:
+      break;
     }
-    fprintf(stderr, "([s]) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "([s]) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   ConfigItem& ConfigItem::operator[](int s) {
-    if(s < 0) throw badIndexExp;
+    if(s < 0) throw BadIndexException();
     return (*this)[(size_t)s];
   }
 
@@ -520,14 +1813,18 @@ namespace configmaps {
     if(s==0) {
       return *this;
     }
-    fprintf(stderr, "([ul]) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "([ul]) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   size_t ConfigItem::append(const ConfigItem &value) {
     return getOrCreateVector()->append(value);
   }
 
+  size_t ConfigItem::append(ConfigItem &&value) {
+    return getOrCreateVector()->append(std::move(value));
+  }
+
   std::vector<ConfigItem>::iterator ConfigItem::erase(std::vector<ConfigItem>::iterator &it) {
     return getOrCreateVector()->erase(it);
   }
@@ -538,64 +1835,83 @@ namespace configmaps {
     return *this;
   }
 
+  ConfigItem& ConfigItem::operator+=(ConfigItem &&value) {
+    *getOrCreateVector() += std::move(value);
+    return *this;
+  }
+
+
+  const char* ConfigItem::c_str() {
+    return getOrCreateAtom()->c_str();
+  }
 
   std::string ConfigItem::getString() {
     return getOrCreateAtom()->getString();
   }
 
   std::string ConfigItem::toString() const {
-    if(item) {
-      ConfigAtom *m = dynamic_cast<ConfigAtom*>(item);
-      if(m) return m->toString();
+    if(isAtom()) {
+      return static_cast<ConfigAtom*>(item)->toString();
     }
-    fprintf(stderr, "([atom::toString]) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "([atom::toString]) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
   size_t ConfigItem::size() const {
+    resolve();
     if(item) {
-      ConfigVector *v = dynamic_cast<ConfigVector*>(item);
-      if(v) return v->size();
-      ConfigMap *m = dynamic_cast<ConfigMap*>(item);
-      if(m) return m->size();
-      ConfigAtom *a = dynamic_cast<ConfigAtom*>(item);
-      if(a) return 1;
+      switch(item->getNodeType()) {
+      case ConfigBase::VECTOR_NODE:
+        return static_cast<ConfigVector*>(item)->size();
+      case ConfigBase::MAP_NODE:
+        return static_cast<ConfigMap*>(item)->size();
+      case ConfigBase::ATOM_NODE:
+        return 1;
+      case ConfigBase::LAZY_NODE:
+        // resolve() replaced the lazy node already
+        break;
+      }
     }
-    throw noTypeExp;
+    throw NoTypeException();
   }
 
   ConfigAtom* ConfigItem::getOrCreateAtom() {
-    ConfigAtom *atom;
+    detach();
     if(!item) {
-      atom = new ConfigAtom();
-      item = atom;
-      item->setParentName(parentName);
-      return atom;
+      return setAtom(ConfigAtom());
+    }
+    switch(item->getNodeType()) {
+    case ConfigBase::ATOM_NODE:
+      return static_cast<ConfigAtom*>(item);
+    case ConfigBase::VECTOR_NODE:
+      return (*static_cast<ConfigVector*>(item))[0].getOrCreateAtom();
+    default:
+      break;
     }
-    atom = dynamic_cast<ConfigAtom*>(item);
-    if(atom) return atom;
-    ConfigVector *v = dynamic_cast<ConfigVector*>(item);
-    if(v) return (*v)[0].getOrCreateAtom();
-    fprintf(stderr, "([atom::getOrCreateAtom]) parent: %s\n", parentName.c_str());
-    throw wrongTypeExp;
+    fprintf(stderr, "([atom::getOrCreateAtom]) path: %s\n", getPath().c_str());
+    throw WrongTypeException();
   }
 
 
   ConfigVector* ConfigItem::getOrCreateVector() {
+    detach();
     ConfigVector *v;
     if(!item) {
       v = new ConfigVector();
       item = v;
-      item->setParentName(parentName);
+      item->setParent(parent);
       return v;
     }
-    v = dynamic_cast<ConfigVector*>(item);
+    v = asVector(item);
     if(v) return v;
-    // we can convert the atom item to a vector
+    // we can convert the atom item to a vector, the item becomes its
+    // first element
     v = new ConfigVector();
-    *v += *item;
+    v->emplace_back();
+    v->back().takeNodeFrom(*this);
     item = v;
-    item->setParentName(parentName);
+    item->setParent(parent);
+    v->back().setParent(v);
     return v;
   }
 
@@ -604,37 +1920,256 @@ namespace configmaps {
    * Private Methods
    ************************/
 
-  void ConfigItem::recursiveLoad(ConfigItem &item, std::string &path) {
+  /**
+   * @brief Expands the URI keys of a loaded tree.
+   *
+   * All included files are parsed first, one include level at a time with
+   * the files of a level parsed concurrently by one pool of threads for
+   * the whole load. The parsed trees are then merged in the depth-first
+   * order of a serial load, thus the result does not depend on the
+   * scheduling. A file included several times is parsed
+   * once, and its errors are only raised when the merge uses it.
+   */
+  class ConfigItem::IncludeLoader {
+  public:
+    explicit IncludeLoader(std::vector<LoadedFile> *files) : files(files) {}
+
+    void load(ConfigItem &item, const std::string &path) {
+      std::vector<std::string> pending;
+      collect(item, path, pending);
+      while(!pending.empty()) {
+        parseAll(pending);
+        std::vector<std::string> next;
+        for(const std::string &file : pending) {
+          Include &include = included[file];
+          if(!include.error) {
+            collect(include.item, getPathOfFile(file), next);
+          }
+        }
+        pending.swap(next);
+      }
+      expand(item, path);
+    }
 
-    if(item.isMap()) {
-      ConfigMap &map = item;
-      ConfigMap::iterator it = item.beginMap();
-      std::list<ConfigMap::iterator> eraseList;
-      std::list<ConfigMap::iterator>::iterator eraseIt;
-      for(; it!=item.endMap(); ++it) {
-        if(it->first == "URI") {
+  private:
+    struct Include {
+      ConfigItem item;
+      std::exception_ptr error;
+      LoadedFile record;
+      bool parsed = false;
+      bool expanding = false;
+      bool expanded = false;
+    };
+
+    /**
+     * Threads that parse the files of one include level after the other.
+     * They are started on demand, at most hardware_concurrency() including
+     * the loading thread, and live as long as the load. The destructor
+     * joins them, also when the load fails.
+     */
+    class WorkerPool {
+    public:
+      WorkerPool() : limit(std::thread::hardware_concurrency()) {}
+
+      ~WorkerPool() {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stopping = true;
+        }
+        wake.notify_all();
+        for(std::thread &thread : threads) {
+          thread.join();
+        }
+      }
+
+      // runs work on up to count threads including the calling one and
+      // returns when all of them are done
+      void run(size_t count, const std::function<void()> &work) {
+        grow(count);
+        std::unique_lock<std::mutex> lock(mutex);
+        job = &work;
+        busy = threads.size();
+        ++generation;
+        lock.unlock();
+        wake.notify_all();
+        work();
+        lock.lock();
+        done.wait(lock, [this]() {return busy == 0;});
+        job = NULL;
+      }
+
+    private:
+      std::vector<std::thread> threads;
+      std::mutex mutex;
+      std::condition_variable wake, done;
+      const std::function<void()> *job = NULL;
+      size_t limit;
+      size_t busy = 0;
+      size_t generation = 0;
+      bool stopping = false;
+
+      void grow(size_t count) {
+        while(threads.size() + 1 < std::min(count, limit)) {
+          try {
+            threads.emplace_back(&WorkerPool::serve, this, generation);
+          } catch(const std::system_error&) {
+            // the started threads and the caller do the work
+            limit = threads.size() + 1;
+          }
+        }
+      }
 
-          std::string file = path + (std::string)it->second;
-          std::string subPath = getPathOfFile(file);
-          ConfigItem m2 = fromYamlFile(file, true);
-          recursiveLoad(m2, subPath);
-          map.append(m2);
-          eraseList.push_back(it);
-        }else {
-          recursiveLoad(it->second, path);
+      void serve(size_t seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+          wake.wait(lock, [&]() {return stopping || generation != seen;});
+          if(stopping) {
+            return;
+          }
+          seen = generation;
+          lock.unlock();
+          (*job)();
+          lock.lock();
+          if(--busy == 0) {
+            done.notify_one();
+          }
         }
       }
-      for(eraseIt=eraseList.begin(); eraseIt!=eraseList.end(); ++eraseIt) {
-        map.erase(*eraseIt);
+    };
+
+    std::vector<LoadedFile> *files;
+    std::map<std::string, Include> included;
+    WorkerPool pool;
+
+    // gathers the files referenced by the tree that are not known yet,
+    // read-only so that shared and cached trees are not copied
+    void collect(const ConfigItem &item, const std::string &path,
+                 std::vector<std::string> &pending) {
+      const ConfigBase *node = item.getNode();
+      if(!node) {
+        return;
       }
-    } else {
-      if(item.isVector()) {
-        std::vector<ConfigItem>::iterator it = ((ConfigVector&)item).begin();
-        for(; it!= ((ConfigVector&)item).end(); ++it) {
-          recursiveLoad(*it, path);
+      if(node->getNodeType() == ConfigBase::MAP_NODE) {
+        for(const auto &it : static_cast<const ConfigMap&>(*node)) {
+          if(it.first != "URI") {
+            collect(it.second, path, pending);
+          } else if((node = it.second.getNode()) &&
+                    node->getNodeType() == ConfigBase::ATOM_NODE) {
+            // other forms are loaded by the merge, see use()
+            std::string file = path + static_cast<const ConfigAtom*>(node)->toString();
+            if(included.emplace(file, Include()).second) {
+              pending.push_back(file);
+            }
+          }
+        }
+      } else if(node->getNodeType() == ConfigBase::VECTOR_NODE) {
+        for(const ConfigItem &child : static_cast<const ConfigVector&>(*node)) {
+          collect(child, path, pending);
+        }
+      }
+    }
+
+    void parse(const std::string &file, Include &include) {
+      try {
+        include.item = parseYamlFile(file, files ? &include.record : NULL);
+      } catch(...) {
+        include.error = std::current_exception();
+      }
+      include.parsed = true;
+    }
+
+    void parseAll(const std::vector<std::string> &pending) {
+      std::vector<Include*> tasks;
+      for(const std::string &file : pending) {
+        tasks.push_back(&included[file]);
+      }
+      std::atomic<size_t> next(0);
+      pool.run(tasks.size(), [&]() {
+        for(size_t i = next++; i < tasks.size(); i = next++) {
+          parse(pending[i], *tasks[i]);
         }
+      });
+    }
+
+    // returns the expanded tree of the file, like loadYamlFile(file, true)
+    ConfigItem& use(const std::string &file) {
+      Include &include = included[file];
+      if(!include.parsed) {
+        parse(file, include);
+      }
+      if(include.error) {
+        std::rethrow_exception(include.error);
+      }
+      if(include.expanding) {
+        throw std::runtime_error("Recursive URI include of File: " + file);
       }
+      if(!include.expanded) {
+        if(files) {
+          files->push_back(include.record);
+        }
+        include.expanding = true;
+        expand(include.item, getPathOfFile(file));
+        include.expanding = false;
+        include.expanded = true;
+      }
+      return include.item;
     }
+
+    // whether the tree has URI keys, read-only like collect()
+    static bool includes(const ConfigItem &item) {
+      const ConfigBase *node = item.getNode();
+      if(node && node->getNodeType() == ConfigBase::MAP_NODE) {
+        for(const auto &it : static_cast<const ConfigMap&>(*node)) {
+          if(it.first == "URI" || includes(it.second)) {
+            return true;
+          }
+        }
+      } else if(node && node->getNodeType() == ConfigBase::VECTOR_NODE) {
+        for(const ConfigItem &child : static_cast<const ConfigVector&>(*node)) {
+          if(includes(child)) {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    // changes only the subtrees with URI keys, the others stay shared
+    void expand(ConfigItem &item, const std::string &path) {
+      if(!includes(item)) {
+        return;
+      }
+      if(item.isMap()) {
+        ConfigMap &map = item;
+        ConfigMap::iterator it = item.beginMap();
+        std::list<ConfigMap::iterator> eraseList;
+        std::list<ConfigMap::iterator>::iterator eraseIt;
+        for(; it!=item.endMap(); ++it) {
+          if(it->first == "URI") {
+            std::string file = path + (std::string)it->second;
+            map.append(use(file));
+            eraseList.push_back(it);
+          }else {
+            expand(it->second, path);
+          }
+        }
+        for(eraseIt=eraseList.begin(); eraseIt!=eraseList.end(); ++eraseIt) {
+          map.erase(*eraseIt);
+        }
+      } else {
+        if(item.isVector()) {
+          std::vector<ConfigItem>::iterator it = ((ConfigVector&)item).begin();
+          for(; it!= ((ConfigVector&)item).end(); ++it) {
+            expand(*it, path);
+          }
+        }
+      }
+    }
+  };
+
+  void ConfigItem::recursiveLoad(ConfigItem &item, std::string &path,
+                                 std::vector<LoadedFile> *files) {
+    IncludeLoader(files).load(item, path);
   }
 
 
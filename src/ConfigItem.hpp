@@ -27,6 +27,8 @@
 
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <vector>
 #include "FIFOMap.h"
 #include "ConfigBase.hpp"
@@ -56,25 +58,26 @@ namespace configmaps {
    * Possible items are: ConfigAtom (scalar values), ConfigVectors (lists), and ConfigMaps (key, Item).
    */
   class ConfigItem {
+  public:
     class NoTypeException: public std::exception {
       virtual const char* what() const throw() {
         return "Item has no type.";
       }
-    } noTypeExp;
+    };
 
     class WrongTypeException: public std::exception {
       virtual const char* what() const throw() {
         return "Item is of wrong type.";
       }
-    } wrongTypeExp;
+    };
 
     class BadIndexException: public std::exception {
       virtual const char* what() const throw() {
         return "Bad index exception.";
       }
-    } badIndexExp;
+    };
+
 
-  public:
     ConfigItem();
     /**
      * @brief Constructor to create a new Item during de-serialization process from a YAML::Node.
@@ -83,11 +86,36 @@ namespace configmaps {
      */
     ConfigItem(const YAML::Node &n);
     ConfigItem(const Json::Value &v);
+    /**
+     * @brief Shares the map or vector of the given item.
+     *
+     * The copies share their subtree until one of them is accessed for
+     * a change, which then duplicates the nodes on its path only, see
+     * detach(). Thus copies of loaded trees are O(1) and the defensive
+     * copies of a large tree cost only the parts that are changed.
+     * A node that handed out references for changes is not shared, it
+     * is copied level by level, see ConfigContainer::setShareable().
+     */
     ConfigItem(const ConfigItem &item);
     ConfigItem(const ConfigBase &item);
+    /**
+     * @brief Takes over the content of the given item without copying it.
+     *
+     * Moving a ConfigItem only passes on the pointer to its map or vector,
+     * which allows to move whole subtrees between maps and vectors in O(1).
+     * Atoms are stored inline and are moved into the new item.
+     */
+    ConfigItem(ConfigItem &&item) noexcept;
+    /**
+     * @brief Moves the given atom, map, or vector into a new item.
+     */
+    ConfigItem(ConfigBase &&item);
     ~ConfigItem();
     ConfigItem& operator=(const ConfigItem&);
     ConfigItem& operator=(const ConfigBase&);
+    ConfigItem& operator=(ConfigItem&&) noexcept;
+    ConfigItem& operator=(ConfigBase&&);
+    void swap(ConfigItem &other) noexcept;
 
     /**
      * @brief Factory function, creating a ConfigItem out of a YAML stream.
@@ -109,6 +137,33 @@ namespace configmaps {
      */
     static ConfigItem fromYamlFile(const std::string &filename,
                                    bool loadURI = false);
+
+    /**
+     * @brief Enables a cache of the trees loaded by fromYamlFile().
+     *
+     * The cache file holds the binary form of the loaded tree, including
+     * the files loaded by URI, and a content hash of every file involved.
+     * It is used as long as none of these files changed, otherwise the
+     * YAML is parsed and the cache is written again. The setting is
+     * process wide and should be made before loading files concurrently.
+     * @param directory Directory of the cache files, which are written
+     * next to the YAML files if it is empty.
+     */
+    static void enableYamlCache(const std::string &directory = "");
+    static void disableYamlCache();
+
+    /**
+     * @brief Enables a process wide cache of the trees parsed from files.
+     *
+     * fromYamlFile() and the URI includes then parse a file only once
+     * and copy the cached tree, as long as its modification time and
+     * size do not change. The least recently used trees are dropped when
+     * the cached trees exceed the budget.
+     * @param budget Approximate memory limit of the cache in bytes.
+     */
+    static void enableParsedFileCache(size_t budget = 64 << 20);
+    // drops all cached trees
+    static void disableParsedFileCache();
     /**
      * @brief Factory function, creating a ConfigItem from a YAML String.
      * @see ConfigItem fromYamlStream(std::istream &in)
@@ -117,13 +172,42 @@ namespace configmaps {
      */
     static ConfigItem fromYamlString(const std::string &s);
 
+    /**
+     * @brief Creates an item that converts the YAML document on demand.
+     *
+     * Maps and vectors keep their YAML::Node until the item is first
+     * accessed, then only their direct children are converted. Reading a
+     * few keys of a large document thus skips the conversion of the
+     * untouched subtrees. Lazy items must not be accessed concurrently
+     * before they are converted, since the conversion happens in place
+     * also on const access.
+     * @throw std::runtime_error if the YAML::Node type is unknown.
+     */
+    static ConfigItem fromYamlNodeLazy(const YAML::Node &n);
+    static ConfigItem fromYamlStringLazy(const std::string &s);
+    /**
+     * @brief Lazy variant of fromYamlFile(), URI keys are not loaded.
+     * @throw std::runtime_error, if the file could not be opened.
+     */
+    static ConfigItem fromYamlFileLazy(const std::string &filename);
+
     static ConfigItem fromJsonStream(std::istream &in);
     static ConfigItem fromJsonString(const std::string &s);
 
-    operator const ConfigBase& () const {return *item;}
-    operator ConfigBase& () {return *item;}
+    /**
+     * @brief Decodes a document written by toBinary().
+     * @throw std::runtime_error if the data is broken or empty.
+     */
+    static ConfigItem fromBinary(const char *data, size_t size);
+    static ConfigItem fromBinary(const std::string &data);
+    static ConfigItem fromBinaryFile(const std::string &filename);
+
+    operator const ConfigBase& () const {resolve(); return *item;}
+    operator ConfigBase& () {detach(); return *item;}
     operator ConfigMap& ();
     operator ConfigMap* ();
+    // hand out a map that can be changed, thus they detach the item like
+    // the non-const ones and are not safe to use concurrently either
     operator ConfigMap& () const;
     operator ConfigMap* () const;
     operator ConfigVector& ();
@@ -132,12 +216,33 @@ namespace configmaps {
     operator ConfigAtom* ();
     operator ConfigItem* () {return this;}
 
-    void setParentName(std::string s) {
-      parentName = s;
-      if(item) {
-        item->setParentName(s);
-      }
+    /**
+     * @brief Sets the map or vector that contains this item.
+     *
+     * Called by ConfigMap and ConfigVector when they take up an item.
+     */
+    void setParent(ConfigBase *p) {
+      ConfigBase *old = parent;
+      parent = p;
+      linkNode(old);
     }
+
+    /**
+     * @brief Returns the atom, map, or vector of the item, NULL if it is empty.
+     */
+    const ConfigBase* getNode() const {
+      resolve();
+      return item;
+    }
+
+    /**
+     * @brief Builds the key path of this item for error messages.
+     * @see ConfigBase::getPath()
+     */
+    std::string getPath() const {
+      return ConfigBase::getPath(parent, item, this);
+    }
+
     /**
      * @brief Calls the emitter function of its base object (if any).
      * @param emitter The emitter to output the stream.
@@ -169,20 +274,50 @@ namespace configmaps {
     void dumpToJsonValue(Json::Value &root) const;
 
     /**
-     * @brief Writes YAML representation of the object to given output stream.
+     * @brief Calls the JSON writer function of its base object.
+     * @throw std::runtime_error if the item is not set.
+     */
+    void dumpToJsonWriter(ConfigJsonWriter &writer) const;
+
+    /**
+     * @brief Writes JSON representation of the object to given output stream.
      * @param out Stream to write on.
+     * @param pretty Indents the text, otherwise it has no whitespace.
      */
-    void toJsonStream(std::ostream &out) const;
+    void toJsonStream(std::ostream &out, bool pretty = true) const;
 
     /**
      * Writes a JSON serialization of the object into a string.
      * @return The resulting JSON string.
      */
-    std::string toJsonString() const;
+    std::string toJsonString(bool pretty = true) const;
 
-    bool isAtom() const;
-    bool isMap() const;
-    bool isVector() const;
+    /**
+     * @brief Writes an item without node as EMPTY_TAG.
+     */
+    void dumpToBinaryWriter(ConfigBinaryWriter &writer) const;
+
+    /**
+     * @brief Encodes the item in the binary format of ConfigBinaryWriter.
+     * @throw std::runtime_error if the item is not set.
+     */
+    std::string toBinary() const;
+    void toBinaryFile(const std::string &filename) const;
+
+    bool isAtom() const {
+      resolve();
+      return item && item->getNodeType() == ConfigBase::ATOM_NODE;
+    }
+
+    bool isMap() const {
+      resolve();
+      return item && item->getNodeType() == ConfigBase::MAP_NODE;
+    }
+
+    bool isVector() const {
+      resolve();
+      return item && item->getNodeType() == ConfigBase::VECTOR_NODE;
+    }
 
     /* Atom types:
      *  - int
@@ -207,10 +342,10 @@ namespace configmaps {
     ConfigItem& operator=(const char* v);
     ConfigItem& operator=(const bool);
 
-    inline const char* c_str() {
-      cStrTmp = getString();
-      return cStrTmp.c_str();
-    }
+    /**
+     * @brief Returns the string of the atom, valid until the atom is changed.
+     */
+    const char* c_str();
 
     std::string toString() const;
     // deprecated atom function
@@ -226,15 +361,18 @@ namespace configmaps {
     }
 
     // map access
-    ConfigItem& operator[](std::string s);
+    ConfigItem& operator[](std::string_view s);
+    ConfigItem& operator[](const std::string &s);
     ConfigItem& operator[](const char* v);
     FIFOMap<std::string, ConfigItem>::iterator beginMap();
     FIFOMap<std::string, ConfigItem>::iterator endMap();
-    FIFOMap<std::string, ConfigItem>::iterator find(std::string key);
-    bool hasKey(std::string key);
+    FIFOMap<std::string, ConfigItem>::iterator find(std::string_view key);
+    bool hasKey(std::string_view key);
     void erase(FIFOMap<std::string, ConfigItem>::iterator &it);
     void appendMap(const ConfigMap &item);
+    void appendMap(ConfigMap &&item);
     void updateMap(const ConfigMap &update);
+    void updateMap(ConfigMap &&update);
 
     // vector access
     ConfigItem& operator[](size_t v);
@@ -242,6 +380,7 @@ namespace configmaps {
     std::vector<ConfigItem>::iterator begin();
     std::vector<ConfigItem>::iterator end();
     size_t append(const ConfigItem &item);
+    size_t append(ConfigItem &&item);
     std::vector<ConfigItem>::iterator erase(std::vector<ConfigItem>::iterator &it);
     /*
       ConfigItem& operator<<(const ConfigItem &item);
@@ -253,11 +392,12 @@ namespace configmaps {
     }
 
     ConfigItem& operator+=(const ConfigItem &item);
+    ConfigItem& operator+=(ConfigItem &&item);
     ConfigItem& operator+=(const ConfigAtom &item) {
-      return *this += ConfigItem((ConfigBase&)item);
+      return *this += ConfigItem((const ConfigBase&)item);
     }
     ConfigItem& operator+=(const ConfigMap &item) {
-      return *this += ConfigItem((ConfigBase&)item);
+      return *this += ConfigItem((const ConfigBase&)item);
     }
 
     template<typename T>
@@ -280,12 +420,61 @@ namespace configmaps {
     ConfigAtom* getOrCreateAtom();
     ConfigVector* getOrCreateVector();
 
+    /**
+     * @brief Number of bytes reserved in every item for an inline atom.
+     *
+     * Atoms are constructed in this storage instead of on the heap, only
+     * maps and vectors are allocated separately. This is the size budget
+     * of ConfigAtom, ConfigItem.cpp checks that an atom fits.
+     */
+    static constexpr size_t ATOM_STORAGE_SIZE = 64;
+
   private:
+    // points to atomStorage if the item holds an atom
     ConfigBase *item;
-    std::string parentName;
-    std::string cStrTmp;
+    // the map or vector that contains this item
+    ConfigBase *parent;
+    alignas(double) unsigned char atomStorage[ATOM_STORAGE_SIZE];
+
+    static ConfigBase* cloneNode(const ConfigBase &node);
+    static ConfigBase* moveNode(ConfigBase &&node);
+    void setNode(ConfigBase *node);
+    ConfigAtom* setAtom(ConfigAtom &&atom);
+    void releaseNode();
+    void takeNodeFrom(ConfigItem &other);
+    // links the node to our parent, see linkNode() in ConfigItem.cpp
+    void linkNode(ConfigBase *from);
+    bool hasInlineAtom() const;
+    // the shared map, vector or lazy node, NULL for atoms and empty items
+    ConfigContainer* container() const;
+    void setLazy(const YAML::Node &n);
+    // gives the item an own map or vector before it is changed
+    void detach();
+    void materialize() const;
+
+    // converts a lazy node before its first use, see fromYamlNodeLazy()
+    void resolve() const {
+      if(item && item->getNodeType() == ConfigBase::LAZY_NODE) {
+        materialize();
+      }
+    }
 
-    static void recursiveLoad(ConfigItem &item, std::string &path);
+    // a file read by loadYamlFile, recorded for the YAML cache
+    struct LoadedFile {
+      std::string path;
+      uint64_t size;
+      uint64_t hash;
+    };
+
+    // expands the URI keys for recursiveLoad, defined in ConfigItem.cpp
+    class IncludeLoader;
+
+    static ConfigItem parseYamlFile(const std::string &filename,
+                                    LoadedFile *record);
+    static ConfigItem loadYamlFile(const std::string &filename, bool loadURI,
+                                   std::vector<LoadedFile> *files);
+    static void recursiveLoad(ConfigItem &item, std::string &path,
+                              std::vector<LoadedFile> *files = NULL);
     static std::string getPathOfFile(const std::string &filename);
   };
 
@@ -0,0 +1,180 @@
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBase.hpp"
+#include <cstring>
+
+using namespace configmaps;
+
+ConfigJsonWriter::ConfigJsonWriter(std::ostream &out, bool pretty)
+  : stream(&out), string(NULL), pretty(pretty), singleLine(false),
+    first(true), afterKey(false), depth(0), used(0) {
+}
+
+ConfigJsonWriter::ConfigJsonWriter(std::string &out, bool pretty)
+  : stream(NULL), string(&out), pretty(pretty), singleLine(false),
+    first(true), afterKey(false), depth(0), used(0) {
+}
+
+void ConfigJsonWriter::write(const ConfigBase &node) {
+  node.dumpToJsonWriter(*this);
+  if(pretty) {
+    put('\n');
+  }
+  flush();
+}
+
+void ConfigJsonWriter::flush() {
+  if(!used) {
+    return;
+  }
+  if(stream) {
+    stream->write(buffer, used);
+  } else {
+    string->append(buffer, used);
+  }
+  used = 0;
+}
+
+void ConfigJsonWriter::put(const char *text, size_t length) {
+  if(length > BUFFER_SIZE - used) {
+    flush();
+    if(length > BUFFER_SIZE) {
+      if(stream) {
+        stream->write(text, length);
+      } else {
+        string->append(text, length);
+      }
+      return;
+    }
+  }
+  memcpy(buffer + used, text, length);
+  used += length;
+}
+
+void ConfigJsonWriter::newLine() {
+  put('\n');
+  for(int i = 0; i < depth; ++i) {
+    put("   ", 3);
+  }
+}
+
+// Writes the separator in front of a key or vector element.
+void ConfigJsonWriter::beginValue() {
+  if(afterKey) {
+    afterKey = false;
+    return;
+  }
+  if(depth == 0) {
+    return;
+  }
+  if(!first) {
+    put(',');
+  }
+  first = false;
+  if(!pretty) {
+    return;
+  }
+  if(singleLine) {
+    put(' ');
+  } else {
+    newLine();
+  }
+}
+
+void ConfigJsonWriter::beginMap() {
+  beginValue();
+  put('{');
+  ++depth;
+  first = true;
+}
+
+void ConfigJsonWriter::key(std::string_view key) {
+  beginValue();
+  putString(key);
+  if(pretty) {
+    put(" : ", 3);
+  } else {
+    put(':');
+  }
+  afterKey = true;
+}
+
+void ConfigJsonWriter::endMap() {
+  --depth;
+  if(!first && pretty) {
+    newLine();
+  }
+  put('}');
+  first = false;
+}
+
+void ConfigJsonWriter::beginVector(bool singleLine) {
+  beginValue();
+  put('[');
+  ++depth;
+  first = true;
+  this->singleLine = singleLine;
+}
+
+void ConfigJsonWriter::endVector() {
+  --depth;
+  if(!first && pretty) {
+    if(singleLine) {
+      put(' ');
+    } else {
+      newLine();
+    }
+  }
+  put(']');
+  first = false;
+  singleLine = false;
+}
+
+void ConfigJsonWriter::writeString(std::string_view value) {
+  beginValue();
+  putString(value);
+}
+
+// Writes the quoted string, unescaped runs are copied at once.
+void ConfigJsonWriter::putString(std::string_view value) {
+  static const char *hex = "0123456789abcdef";
+  put('"');
+  const char *run = value.data();
+  const char *end = run + value.size();
+  for(const char *p = run; p != end; ++p) {
+    unsigned char c = *p;
+    if(c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    put(run, p - run);
+    run = p + 1;
+    switch(c) {
+    case '"': put("\\\"", 2); break;
+    case '\\': put("\\\\", 2); break;
+    case '\b': put("\\b", 2); break;
+    case '\f': put("\\f", 2); break;
+    case '\n': put("\\n", 2); break;
+    case '\r': put("\\r", 2); break;
+    case '\t': put("\\t", 2); break;
+    default: {
+      char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+      put(escape, 6);
+    }
+    }
+  }
+  put(run, end - run);
+  put('"');
+}
+
+void ConfigJsonWriter::writeBool(bool value) {
+  beginValue();
+  if(value) {
+    put("true", 4);
+  } else {
+    put("false", 5);
+  }
+}
+
+void ConfigJsonWriter::writeNumber(std::string_view value) {
+  beginValue();
+  put(value.data(), value.size());
+}
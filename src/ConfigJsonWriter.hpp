@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <ostream>
+
+namespace configmaps {
+
+  class ConfigBase;
+
+  /**
+   * @brief Writes JSON text straight to a stream or string.
+   *
+   * The nodes dump themselves with dumpToJsonWriter(), no Json::Value is
+   * built in between. The text is collected in a fixed buffer that is
+   * flushed whenever it is full. Pretty output follows the layout of the
+   * jsoncpp styled writer, compact output contains no whitespace.
+   */
+  class ConfigJsonWriter {
+  public:
+    ConfigJsonWriter(std::ostream &out, bool pretty = true);
+    ConfigJsonWriter(std::string &out, bool pretty = true);
+
+    /**
+     * @brief Writes the node as JSON document and flushes the buffer.
+     */
+    void write(const ConfigBase &node);
+
+    void beginMap();
+    void key(std::string_view key);
+    void endMap();
+
+    /**
+     * @param singleLine Puts all elements on one line in pretty mode,
+     * only meant for short vectors of atoms.
+     */
+    void beginVector(bool singleLine = false);
+    void endVector();
+
+    void writeString(std::string_view value);
+    void writeBool(bool value);
+    // writes a formatted number as it is
+    void writeNumber(std::string_view value);
+
+    bool isPretty() const {
+      return pretty;
+    }
+
+    void flush();
+
+    // the width up to which pretty vectors are written on one line
+    static const size_t LINE_WIDTH = 74;
+
+  private:
+    static const size_t BUFFER_SIZE = 4096;
+
+    std::ostream *stream;
+    std::string *string;
+    bool pretty;
+    bool singleLine;
+    // no separator is needed before the first value of a container
+    bool first;
+    bool afterKey;
+    int depth;
+    size_t used;
+    char buffer[BUFFER_SIZE];
+
+    void beginValue();
+    void newLine();
+
+    void put(char c) {
+      if(used == BUFFER_SIZE) {
+        flush();
+      }
+      buffer[used++] = c;
+    }
+
+    void put(const char *text, size_t length);
+    void putString(std::string_view value);
+  }; // end of class ConfigJsonWriter
+
+} // end of namespace configmaps
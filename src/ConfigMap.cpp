@@ -7,6 +7,8 @@
 
 #include "ConfigAtom.hpp"
 #include "ConfigVector.hpp"
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBinary.hpp"
 #include "ConfigSchema.hpp"
 
 // #define VERBOSE
@@ -22,7 +24,7 @@ namespace configmaps
   /************************
    * Implementation
    ************************/
-  ConfigMap::ConfigMap()
+  ConfigMap::ConfigMap() : ConfigContainer(MAP_NODE)
   {
     if (ConfigBase::debugLevel == 0)
     {
@@ -38,6 +40,41 @@ namespace configmaps
     }
   }
 
+  ConfigMap::ConfigMap(const ConfigMap &other)
+    : ConfigContainer(other), FIFOMap<std::string, ConfigItem>(other)
+  {
+    adoptItems();
+  }
+
+  ConfigMap::ConfigMap(ConfigMap &&other) noexcept
+    : ConfigContainer(std::move(other)),
+      FIFOMap<std::string, ConfigItem>(std::move(other))
+  {
+    adoptItems();
+  }
+
+  ConfigMap &ConfigMap::operator=(const ConfigMap &other)
+  {
+    FIFOMap<std::string, ConfigItem>::operator=(other);
+    adoptItems();
+    return *this;
+  }
+
+  ConfigMap &ConfigMap::operator=(ConfigMap &&other) noexcept
+  {
+    FIFOMap<std::string, ConfigItem>::operator=(std::move(other));
+    adoptItems();
+    return *this;
+  }
+
+  void ConfigMap::adoptItems()
+  {
+    for (auto &it : *this)
+    {
+      it.second.setParent(this);
+    }
+  }
+
   ConfigMap::ConfigMap(const YAML::Node &n) : ConfigMap()
   {
     for (YAML::const_iterator it = n.begin(); it != n.end(); ++it)
@@ -50,7 +87,7 @@ namespace configmaps
       if (it->second.IsNull())
         continue;
       // if not null:
-      (*this).emplace(key, ConfigItem(it->second));
+      (*this).emplace(key, ConfigItem(it->second)).first->second.setParent(this);
     }
   }
 
@@ -69,7 +106,7 @@ namespace configmaps
       if ((*it).isNull())
         continue;
       // if not null:
-      (*this).emplace(key, ConfigItem(*it));
+      (*this).emplace(key, ConfigItem(*it)).first->second.setParent(this);
     }
   }
 
@@ -80,8 +117,8 @@ namespace configmaps
     {
       throw std::invalid_argument("Given input stream does not have map as root element in YAML!");
     }
-    ConfigMap map = item;
-    return map;
+    // take over the parsed root instead of copying the tree
+    return std::move((ConfigMap &)item);
   }
 
   ConfigMap ConfigMap::fromYamlFile(const string &filename, bool loadURI)
@@ -96,8 +133,8 @@ namespace configmaps
     {
       throw std::invalid_argument("Given input stream does not have map as root element in YAML!");
     }
-    ConfigMap map = item;
-    return map;
+    // take over the parsed root instead of copying the tree
+    return std::move((ConfigMap &)item);
   }
 
   ConfigMap ConfigMap::fromYamlString(const string &s)
@@ -113,8 +150,8 @@ namespace configmaps
     {
       throw std::invalid_argument("Given input stream does not have map as root element in YAML!");
     }
-    ConfigMap map = item;
-    return map;
+    // take over the parsed root instead of copying the tree
+    return std::move((ConfigMap &)item);
   }
 
   ConfigMap ConfigMap::fromJsonString(const string &s)
@@ -123,6 +160,26 @@ namespace configmaps
     return fromJsonStream(sin);
   }
 
+  ConfigMap ConfigMap::fromBinary(const string &data)
+  {
+    ConfigItem item = ConfigItem::fromBinary(data);
+    if (!item.isMap())
+    {
+      throw std::invalid_argument("Given binary data does not have map as root element!");
+    }
+    return std::move((ConfigMap &)item);
+  }
+
+  ConfigMap ConfigMap::fromBinaryFile(const string &filename)
+  {
+    ConfigItem item = ConfigItem::fromBinaryFile(filename);
+    if (!item.isMap())
+    {
+      throw std::invalid_argument("Given binary file does not have map as root element!");
+    }
+    return std::move((ConfigMap &)item);
+  }
+
   void ConfigMap::dumpToYamlEmitter(YAML::Emitter &emitter) const
   {
     emitter << YAML::BeginMap;
@@ -155,6 +212,28 @@ namespace configmaps
     }
   }
 
+  void ConfigMap::dumpToJsonWriter(ConfigJsonWriter &writer) const
+  {
+    writer.beginMap();
+    for (const_iterator it = this->begin(); it != this->end(); ++it)
+    {
+      writer.key(it->first);
+      it->second.dumpToJsonWriter(writer);
+    }
+    writer.endMap();
+  }
+
+  void ConfigMap::dumpToBinaryWriter(ConfigBinaryWriter &writer) const
+  {
+    writer.beginMap(size());
+    for (const_iterator it = this->begin(); it != this->end(); ++it)
+    {
+      writer.key(it->first);
+      it->second.dumpToBinaryWriter(writer);
+    }
+    writer.endMap();
+  }
+
   /***************************
    * static helper functions *
    ***************************/
@@ -178,30 +257,62 @@ namespace configmaps
       return str.substr(front_idx, back_idx - front_idx + 1);
   }
 
-  bool ConfigMap::hasKey(std::string key)
+  bool ConfigMap::hasKey(std::string_view key) const
   {
     return (find(key) != end());
   }
 
-  void ConfigMap::updateMap(ConfigMap &update)
+  void ConfigMap::append(const ConfigMap &other)
+  {
+    for (const auto &it : other)
+    {
+      operator[](it.first) = it.second;
+    }
+  }
+
+  void ConfigMap::append(ConfigMap &&other)
+  {
+    for (auto &it : other)
+    {
+      operator[](it.first) = std::move(it.second);
+    }
+    other.clear();
+  }
+
+  void ConfigMap::updateMap(const ConfigMap &update)
   {
-    for (auto it : update)
+    for (const auto &it : update)
     {
-      if (!hasKey(it.first))
+      iterator own = find(it.first);
+      if (own != end() and own->second.isMap() and it.second.isMap())
+      {
+        own->second.updateMap(static_cast<const ConfigMap &>(
+                               (const ConfigBase &)it.second));
+      }
+      else
       {
         operator[](it.first) = it.second;
-        continue;
       }
-      if (operator[](it.first).isMap() and it.second.isMap())
+    }
+  }
+
+  void ConfigMap::updateMap(ConfigMap &&update)
+  {
+    for (auto &it : update)
+    {
+      iterator own = find(it.first);
+      if (own != end() and own->second.isMap() and it.second.isMap())
       {
-        operator[](it.first).updateMap(it.second);
+        own->second.updateMap(std::move((ConfigMap &)it.second));
       }
       else
       {
-        operator[](it.first) = it.second;
+        operator[](it.first) = std::move(it.second);
       }
     }
+    update.clear();
   }
+
   bool ConfigMap::validate(ConfigMap &schema)
   {
     ConfigSchema cs(schema);
@@ -26,6 +26,7 @@
 #endif
 
 #include <string>
+#include <string_view>
 
 #include "FIFOMap.h"
 #include "ConfigItem.hpp"
@@ -45,7 +46,7 @@ namespace configmaps {
   // only functions used from misc.h
   std::string trim(const std::string& str);
 
-  class ConfigMap: public ConfigBase, public FIFOMap<std::string, ConfigItem> {
+  class ConfigMap: public ConfigContainer, public FIFOMap<std::string, ConfigItem> {
   public:
     /**
      * @brief Create and fill the object with values from YAML node.
@@ -60,34 +61,40 @@ namespace configmaps {
     ConfigMap(const Json::Value &v);
 
     ConfigMap();
-
-    ConfigItem& operator[](const std::string &name){
-      ConfigItem &w = FIFOMap<std::string, ConfigItem>::operator[](name);
-
-      if(find(name) == end()){
-        w.setParentName(name);
+    ConfigMap(const ConfigMap &other);
+    ConfigMap(ConfigMap &&other) noexcept;
+    ConfigMap& operator=(const ConfigMap &other);
+    ConfigMap& operator=(ConfigMap &&other) noexcept;
+
+    ConfigItem& operator[](std::string_view name) {
+      std::pair<iterator, bool> it = try_emplace(name);
+      if(it.second) {
+        it.first->second.setParent(this);
       }
+      return it.first->second;
+    }
 
-      return w;
+    ConfigItem& operator[](const std::string &name) {
+      return (*this)[std::string_view(name)];
     }
 
     ConfigItem& operator[](const char *name) {
-      ConfigItem &w = FIFOMap<std::string, ConfigItem>::operator[](name);
-      if(find(name) == end()){
-        w.setParentName(name);
-      }
-
-      return w;
+      return (*this)[std::string_view(name)];
     }
 
-    bool hasKey(std::string key);
-    void updateMap(ConfigMap &update);
+    bool hasKey(std::string_view key) const;
+    void append(const ConfigMap &other);
+    void append(ConfigMap &&other);
+    void updateMap(const ConfigMap &update);
+    void updateMap(ConfigMap &&update);
 
     static ConfigMap fromYamlStream(std::istream &in);
     static ConfigMap fromYamlFile(const std::string &filename, bool loadURI = false);
     static ConfigMap fromYamlString(const std::string &s);
     static ConfigMap fromJsonStream(std::istream &in);
     static ConfigMap fromJsonString(const std::string &s);
+    static ConfigMap fromBinary(const std::string &data);
+    static ConfigMap fromBinaryFile(const std::string &filename);
 
     /**
      * @brief Create YAML representation of this ConfigMap to a YAML::Emmitter.
@@ -101,19 +108,28 @@ namespace configmaps {
      */
     virtual void dumpToJsonValue(Json::Value &root) const;
 
+    /**
+     * @brief Writes the JSON object of this ConfigMap in insertion order.
+     */
+    virtual void dumpToJsonWriter(ConfigJsonWriter &writer) const override;
+
+    virtual void dumpToBinaryWriter(ConfigBinaryWriter &writer) const override;
+
     // checks if the key is in the list, if not return the given default value
-    template<typename T> T get(const std::string &key, const T &defaultValue) {
-      if(find(key) != end()){
-        return (T) (*this)[key];
+    template<typename T> T get(std::string_view key, const T &defaultValue) {
+      iterator it = find(key);
+      if(it != end()){
+        return (T) it->second;
       }
       return defaultValue;
     }
 
     // checks if the key is in the list, if not add the given default value
     // and return it
-    template<typename T> T getOrCreate(const std::string &key, const T &defaultValue) {
-      if(find(key) != end()){
-        return (T) (*this)[key];
+    template<typename T> T getOrCreate(std::string_view key, const T &defaultValue) {
+      iterator it = find(key);
+      if(it != end()){
+        return (T) it->second;
       }
       (*this)[key] = defaultValue;
       return defaultValue;
@@ -124,6 +140,11 @@ namespace configmaps {
     bool validate(ConfigMap &schema);
     bool validate(ConfigSchema &schema);
 
+  private:
+    // sets this map as parent of all items
+    void adoptItems();
+    // a rehash moved the items
+    void relocated() override {adoptItems();}
 
   };
 } // end of namespace configmaps
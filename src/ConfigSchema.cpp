@@ -3,6 +3,9 @@
 #include "ConfigItem.hpp"
 #include "ConfigVector.hpp"
 #include "ConfigMap.hpp"
+#include <iostream>
+#include <limits>
+#include <stdexcept>
 
 using namespace configmaps;
 
@@ -13,8 +16,116 @@ const std::map<std::string, std::vector<configmaps::ConfigAtom::ItemType>> Confi
     {"boolean", {ConfigAtom::BOOL_TYPE}},
 };
 
-ConfigSchema::ConfigSchema(const ConfigMap &schema) : m_schema(schema) {}
-ConfigSchema::ConfigSchema() {}
+ConfigSchema::ConfigSchema(const ConfigMap &schema)
+{
+    // compiled from a copy, reading the schema items may convert them
+    ConfigMap copy = schema;
+    compile(copy);
+}
+
+ConfigSchema::ConfigSchema()
+{
+    ConfigMap empty;
+    compile(empty);
+}
+
+size_t ConfigSchema::compile(ConfigMap &schema)
+{
+    // reserve the index first, sub-schemas are appended while compiling
+    size_t index = m_program.size();
+    m_program.emplace_back();
+    std::vector<Field> fields;
+    for (auto &[key, value] : schema)
+    {
+        Field field;
+        field.key = key;
+        compile_field(field, value);
+        fields.push_back(std::move(field));
+    }
+    m_program[index] = std::move(fields);
+    return index;
+}
+
+void ConfigSchema::compile_field(Field &field, ConfigItem &value)
+{
+    try
+    {
+        field.has_required = value.hasKey("required");
+        if (field.has_required)
+            field.required = (bool)value["required"];
+    }
+    catch (...)
+    {
+        field.error = std::current_exception();
+        field.error_at_start = true;
+        return;
+    }
+    try
+    {
+        field.has_type = value.hasKey("type");
+        field.type = resolve_type(field.has_type ? (std::string)value["type"] : "");
+        if (field.type.kind == Type::OBJECT)
+        {
+            field.has_properties = value.hasKey("properties");
+            if (field.has_properties)
+                field.properties = compile(value["properties"]);
+        }
+        else if (field.type.kind == Type::ARRAY)
+        {
+            field.has_contains = value.hasKey("contains");
+            if (field.has_contains)
+            {
+                ConfigItem &contains = value["contains"];
+                field.contains_has_type = contains.hasKey("type");
+                if (field.contains_has_type)
+                {
+                    field.contains_type = resolve_type((std::string)contains["type"]);
+                    if (field.contains_type.kind == Type::OBJECT)
+                    {
+                        field.contains_has_properties = contains.hasKey("properties");
+                        if (field.contains_has_properties)
+                            field.contains_properties = compile(contains["properties"]);
+                    }
+                }
+            }
+        }
+        field.has_minimum = value.hasKey("minimum");
+        if (field.has_minimum)
+            field.minimum = value["minimum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? (double)value["minimum"] : static_cast<double>((int)(value["minimum"]));
+        field.has_maximum = value.hasKey("maximum");
+        if (field.has_maximum)
+            field.maximum = value["maximum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? (double)value["maximum"] : static_cast<double>((int)(value["maximum"]));
+    }
+    catch (...)
+    {
+        field.error = std::current_exception();
+    }
+}
+
+ConfigSchema::Type ConfigSchema::resolve_type(const std::string &name)
+{
+    Type type;
+    type.name = name;
+    if (name == "object")
+    {
+        type.kind = Type::OBJECT;
+    }
+    else if (name == "array")
+    {
+        type.kind = Type::ARRAY;
+    }
+    else
+    {
+        auto it = SCHEMA_ATOM_TYPES.find(name);
+        if (it != SCHEMA_ATOM_TYPES.end())
+        {
+            type.kind = Type::ATOM;
+            type.atom_types = &it->second;
+            type.numeric = name == "number" or name == "integer";
+        }
+    }
+    return type;
+}
 
 bool ConfigSchema::validate(ConfigMap &config)
 {
@@ -23,25 +134,33 @@ bool ConfigSchema::validate(ConfigMap &config)
         return false;
 
     // Validate mandatory keys
-    if (not validate_keys(config, m_schema))
+    if (not validate_keys(config, 0))
         return false;
 
     // Validate value types
-    if (not validate_types(config, m_schema))
+    if (not validate_types(config, 0))
         return false;
 
     return true;
 }
 
-bool ConfigSchema::has_corresponding_type(ConfigItem &config_item, const std::string &type)
+bool ConfigSchema::has_corresponding_type(ConfigItem &config_item, const Type &type)
 {
-    if (type == "object")
+    switch (type.kind)
+    {
+    case Type::OBJECT:
         return config_item.isMap();
-    if (type == "array")
+    case Type::ARRAY:
         return config_item.isVector();
-    for(auto atomic_type : SCHEMA_ATOM_TYPES.at(type))
+    case Type::UNKNOWN:
+        throw std::out_of_range("ConfigSchema: unknown schema type \"" + type.name + "\"");
+    default:
+        break;
+    }
+    ConfigAtom *atom = config_item.getOrCreateAtom();
+    for (auto atomic_type : *type.atom_types)
     {
-        if(config_item.getOrCreateAtom()->testType(atomic_type))
+        if (atom->testType(atomic_type))
         {
             return true;
         }
@@ -50,21 +169,17 @@ bool ConfigSchema::has_corresponding_type(ConfigItem &config_item, const std::st
     return false;
 }
 
-bool ConfigSchema::is_known_type(const std::string &type)
+bool ConfigSchema::validate_keys(ConfigMap &config, size_t schema)
 {
-    if (SCHEMA_ATOM_TYPES.count(type))
-        return true;
-    return type == "object" or type == "array";
-}
-
-bool ConfigSchema::validate_keys(ConfigMap &config, ConfigMap &schema)
-{
-    for (auto const &[key, value] : schema)
+    for (const Field &field : m_program[schema])
     {
+        const std::string &key = field.key;
+        if (field.error_at_start)
+            std::rethrow_exception(field.error);
         // Check if required keys in schema exist in our config
-        if (value.hasKey("required"))
+        if (field.has_required)
         {
-            if ((bool)value["required"] == true)
+            if (field.required)
             {
                 // there is a required field with a true value,
                 // that means, schema 'key' MUST exist in 'config'
@@ -82,61 +197,61 @@ bool ConfigSchema::validate_keys(ConfigMap &config, ConfigMap &schema)
             if (not config.hasKey(key))
                 continue;
         }
+        if (field.error)
+            std::rethrow_exception(field.error);
         // Take the opportunity to validate schema keys
         // Check if we have a type field in schema, its mandatory..
-        if (not value.hasKey("type"))
+        if (not field.has_type)
         {
             std::cerr << "ConfigSchema::validate_keys: Missing schema type field for \"" << key << "\"" << std::endl;
             return false;
         }
         // If the item is an object, validate it recursively
-        if (value["type"] == "object")
+        if (field.type.kind == Type::OBJECT)
         {
             if (not config[key].isMap())
             {
                 std::cerr << "ConfigSchema::validate_keys: Expected \"" << key << "\" to be an object" << std::endl;
                 return false;
             }
-            if (not value.hasKey("properties"))
+            if (not field.has_properties)
             {
                 std::cerr << "ConfigSchema::validate_keys: Expected \"properties\" field in object \"" << key << "\"" << std::endl;
                 return false;
             }
-            ConfigMap sub_schema = value["properties"];
-            if (not validate_keys(config[key], sub_schema))
+            if (not validate_keys(config[key], field.properties))
             {
                 return false;
             }
         }
-        else if (value["type"] == "array") // If the item is an array of objects, validate its elements
+        else if (field.type.kind == Type::ARRAY) // If the item is an array of objects, validate its elements
         {
             if (not config[key].isVector())
             {
                 std::cerr << "ConfigSchema::validate_keys: Expected \"" << key << "\" to be an array" << std::endl;
                 return false;
             }
-            if (not value.hasKey("contains"))
+            if (not field.has_contains)
             {
                 std::cerr << "ConfigSchema::validate_keys: Expected array \"" << key << "\" to have \"contains\" field" << std::endl;
                 return false;
             }
-            if (not value["contains"].hasKey("type"))
+            if (not field.contains_has_type)
             {
                 std::cerr << "ConfigSchema::validate_keys: Expected schema \"type\" field in \"contains\" for array \"" << key << "\"" << std::endl;
                 return false;
             }
             // If its an array containing object elements, validate each object
-            if (value["contains"]["type"] == "object")
+            if (field.contains_type.kind == Type::OBJECT)
             {
                 for (ConfigItem &obj : config[key])
                 {
-                    if (not value["contains"].hasKey("properties"))
+                    if (not field.contains_has_properties)
                     {
                         std::cerr << "ConfigSchema::validate_keys: Expected \"properties\" field in object \"" << key << "\"" << std::endl;
                         return false;
                     }
-                    ConfigMap sub_schema = value["contains"]["properties"];
-                    if (not validate_keys(obj, sub_schema))
+                    if (not validate_keys(obj, field.contains_properties))
                     {
                         return false;
                     }
@@ -147,34 +262,38 @@ bool ConfigSchema::validate_keys(ConfigMap &config, ConfigMap &schema)
     return true;
 }
 
-bool ConfigSchema::validate_types(ConfigMap &config, ConfigMap &schema)
+bool ConfigSchema::validate_types(ConfigMap &config, size_t schema)
 {
-    for (auto const &[key, value] : schema)
+    for (const Field &field : m_program[schema])
     {
+        const std::string &key = field.key;
         if (not config.hasKey(key))
             continue; // A not required field, doesn't seem to exist. skip it.
+        if (field.error)
+            std::rethrow_exception(field.error);
 
         // Check first if the desired schema type is known
-        if (not is_known_type(value["type"]))
+        if (field.type.kind == Type::UNKNOWN)
         {
-            std::cerr << "ConfigSchema::validate_types: Invalid schema type " << (std::string)value["type"] << " in \"" << key << '\"' << std::endl;
+            std::cerr << "ConfigSchema::validate_types: Invalid schema type " << field.type.name << " in \"" << key << '\"' << std::endl;
             return false;
         }
         // Check if the type defined in the schema is matching the type we have in config
-        if (not has_corresponding_type(config[key], value["type"]))
+        if (not has_corresponding_type(config[key], field.type))
         {
-            std::cerr << "ConfigSchema::validate_types: Invalid value for \"" << key << "\", expected \"" << (std::string)value["type"] << '\"' << std::endl;
+            std::cerr << "ConfigSchema::validate_types: Invalid value for \"" << key << "\", expected \"" << field.type.name << '\"' << std::endl;
             return false;
         }
         // Check constraints
-        if (not validate_constraints(config, key, value))
+        if (not validate_constraints(config, field))
         {
             return false;
         }
         // Validate sub objects (recursively) obj{obj{}...}
         if (config[key].isMap())
         {
-            if (not validate_types(config[key], value["properties"]))
+            // a map only matches an object type
+            if (field.has_properties and not validate_types(config[key], field.properties))
                 return false;
         }
         // Validate sub objects within the array if any [obj{}, obj{}, ...]
@@ -182,15 +301,15 @@ bool ConfigSchema::validate_types(ConfigMap &config, ConfigMap &schema)
         {
             for (ConfigItem &o : config[key])
             {
-                if (value["contains"]["type"] == "object")
+                if (field.contains_type.kind == Type::OBJECT)
                 {
-                    ConfigMap sub_schema = value["contains"]["properties"];
-                    if (not validate_types(o, sub_schema))
+                    ConfigMap &obj = o;
+                    if (field.contains_has_properties and not validate_types(obj, field.contains_properties))
                         return false;
                 }
                 else
                 {
-                    if (not has_corresponding_type(o, value["contains"]["type"]))
+                    if (not has_corresponding_type(o, field.contains_type))
                     {
                         std::cerr << "ConfigSchema::validate_types: Invalid type for \"" << key << '\"' << std::endl;
                         return false;
@@ -202,58 +321,55 @@ bool ConfigSchema::validate_types(ConfigMap &config, ConfigMap &schema)
     return true;
 }
 
-bool ConfigSchema::validate_constraints(ConfigMap &config, const std::string &key, ConfigMap &schema)
+bool ConfigSchema::validate_constraints(ConfigMap &config, const Field &field)
 {
+    const std::string &key = field.key;
     // minimum and maximum:
-    if (schema.hasKey("minimum") or schema.hasKey("maximum"))
+    if (field.has_minimum or field.has_maximum)
     {
         // Check atom constraints, floating points and integers
-        if (schema["type"] != "number" and schema["type"] != "integer")
+        if (not field.type.numeric)
         {
             std::cerr << "ConfigSchema::validate_constraints: Invalid minimum,maximum schema in non-atom type in \"" << key << '\"' << std::endl;
             return false;
         }
 
-        // Handle minimum constrains
-        double minimum, maximum;
-        if (schema.hasKey("minimum"))
-            minimum = schema["minimum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? (double)schema["minimum"] : static_cast<double>((int)(schema["minimum"]));
-        if (schema.hasKey("maximum"))
-            maximum = schema["maximum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? (double)schema["maximum"] : static_cast<double>((int)(schema["maximum"]));
-
-        // Check if the config item's value is in range [minimum, maximum]
-        double value = config[key].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? (double)config[key] : static_cast<double>((int)(config[key]));
-        if (schema.hasKey("minimum") and schema.hasKey("maximum"))
+        // Check if the config item's value is in range [minimum, maximum],
+        // read from a copy since reading fixes the type of a parsed atom
+        ConfigAtom atom = *config[key].getOrCreateAtom();
+        double value = atom.testType(ConfigAtom::DOUBLE_TYPE) ? (double)atom : static_cast<double>((int)atom);
+        if (field.has_minimum and field.has_maximum)
         {
             // Check if minimum is less than maximum
-            if (minimum > maximum)
+            if (field.minimum > field.maximum)
             {
                 std::cerr << "ConfigSchema::validate_constraints: minimum value is greater than the maximum value in \"" << key << '\"' << std::endl;
                 return false;
             }
-            if (value < minimum or value > maximum)
+            if (value < field.minimum or value > field.maximum)
             {
-                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << minimum << ", " << maximum << "] in \"" << key << '\"' << std::endl;
+                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << field.minimum << ", " << field.maximum << "] in \"" << key << '\"' << std::endl;
                 return false;
             }
         }
-        else if (schema.hasKey("minimum") and not schema.hasKey("maximum"))
+        else if (field.has_minimum)
         {
-            if (value < minimum)
+            if (value < field.minimum)
             {
-                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << minimum << ", " << (schema["maximum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? std::numeric_limits<double>::max() : std::numeric_limits<int>::max()) << "] in \"" << key << '\"' << std::endl;
+                // the open bound is shown as the int range
+                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << field.minimum << ", " << static_cast<double>(std::numeric_limits<int>::max()) << "] in \"" << key << '\"' << std::endl;
                 return false;
             }
         }
-        else if (schema.hasKey("maximum") and not schema.hasKey("minimum"))
+        else
         {
-            if (value > maximum)
+            if (value > field.maximum)
             {
-                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << (schema["minimum"].getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE) ? std::numeric_limits<double>::min() : std::numeric_limits<int>::min()) << ", " << maximum << "] in \"" << key << '\"' << std::endl;
+                std::cerr << "ConfigSchema::validate_constraints: value " << value << " is out of range [" << static_cast<double>(std::numeric_limits<int>::min()) << ", " << field.maximum << "] in \"" << key << '\"' << std::endl;
                 return false;
             }
         }
     }
     
     return true;
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <map>
 #include <vector>
+#include <string>
+#include <exception>
 #include "ConfigMap.hpp"
 #include "ConfigAtom.hpp"
 
@@ -29,6 +31,9 @@ namespace configmaps
         /**
          * @brief Construct a new ConfigSchema object by 
          * ConfigMap of schema structure 
+         *
+         * The schema is compiled into a list of fields per map, validate()
+         * only runs through these and does not read the schema again.
          */
         explicit ConfigSchema(const ConfigMap &schema);
         ConfigSchema() ;
@@ -42,18 +47,66 @@ namespace configmaps
         bool validate(ConfigMap &config);
 
     private:
-        ConfigMap m_schema;
+        /**
+         * @brief Type named by a "type" field, resolved at construction.
+         */
+        struct Type
+        {
+            enum Kind {UNKNOWN, OBJECT, ARRAY, ATOM};
+            Kind kind = UNKNOWN;
+            std::string name;
+            // accepted atom types of an ATOM type
+            const std::vector<ConfigAtom::ItemType> *atom_types = nullptr;
+            // integer or number, the types with minimum and maximum
+            bool numeric = false;
+        };
+
+        /**
+         * @brief Compiled schema entry of one key.
+         *
+         * Holds everything validate() reads from the schema, sub-schemas
+         * are referenced by their index in m_program.
+         */
+        struct Field
+        {
+            std::string key;
+            bool has_required = false;
+            bool required = false;
+            bool has_type = false;
+            Type type;
+            bool has_properties = false;
+            size_t properties = 0;
+            bool has_contains = false;
+            bool contains_has_type = false;
+            Type contains_type;
+            bool contains_has_properties = false;
+            size_t contains_properties = 0;
+            bool has_minimum = false;
+            bool has_maximum = false;
+            double minimum = 0;
+            double maximum = 0;
+            // a malformed schema entry throws once it is used, as before
+            std::exception_ptr error;
+            bool error_at_start = false;
+        };
+
+        // the compiled schema maps, the root map is the first
+        std::vector<std::vector<Field>> m_program;
         static const std::map<std::string, std::vector<ConfigAtom::ItemType>> SCHEMA_ATOM_TYPES;
         
     private:
-        bool has_corresponding_type(ConfigItem &config_item, const std::string &type);
+        size_t compile(ConfigMap &schema);
+
+        void compile_field(Field &field, ConfigItem &value);
+
+        static Type resolve_type(const std::string &name);
 
-        bool is_known_type(const std::string &type);
+        bool has_corresponding_type(ConfigItem &config_item, const Type &type);
 
-        bool validate_keys(ConfigMap &config, ConfigMap& schema);
+        bool validate_keys(ConfigMap &config, size_t schema);
 
-        bool validate_types(ConfigMap &config, ConfigMap& schema);
+        bool validate_types(ConfigMap &config, size_t schema);
 
-        bool validate_constraints(ConfigMap& config_item, const std::string& key, ConfigMap& schema);
+        bool validate_constraints(ConfigMap& config_item, const Field &field);
     };
 }
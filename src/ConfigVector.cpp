@@ -1,4 +1,6 @@
 #include "ConfigVector.hpp"
+#include "ConfigJsonWriter.hpp"
+#include "ConfigBinary.hpp"
 #include <yaml-cpp/yaml.h>
 #include <json/json.h>
 #include <iostream>
@@ -6,27 +8,27 @@
 
 using namespace configmaps;
 
-ConfigVector::ConfigVector(const YAML::Node &n) {
+ConfigVector::ConfigVector(const YAML::Node &n) : ConfigContainer(VECTOR_NODE) {
 
   if(n.Type() != YAML::NodeType::Sequence){
     throw std::runtime_error("Failed to create config vector, given YAML::Node is not a sequence!");
   }
 
   //    YAML::const_iterator it;
+  reserve(n.size());
   for(auto &it : n){ //it = n.begin(); it != n.end(); ++it){
-    ConfigItem item(it);
-    push_back(item);
+    emplace_back(it);
   }
 }
 
-ConfigVector::ConfigVector(const Json::Value &v) {
+ConfigVector::ConfigVector(const Json::Value &v) : ConfigContainer(VECTOR_NODE) {
   if(!v.isArray()){
     throw std::runtime_error("Failed to create config vector, given Json::Value is not a sequence!");
   }
 
-  for(int i=0; i<v.size(); ++i) {
-    ConfigItem item(v[i]);
-    push_back(item);
+  reserve(v.size());
+  for(Json::ArrayIndex i=0; i<v.size(); ++i) {
+    emplace_back(v[i]);
   }
 }
 
@@ -35,7 +37,7 @@ void ConfigVector::dumpToYamlEmitter(YAML::Emitter &emitter) const {
   emitter << YAML::BeginSeq;
 
   if(!(emitter.good() && 1)){
-    std::string s = getParentName();
+    std::string s = getPath();
     std::cerr << "problem with ConfigVector for: " << std::endl << s.c_str() << std::endl;
   }
   assert(emitter.good() && 1);
@@ -59,3 +61,33 @@ void ConfigVector::dumpToJsonValue(Json::Value &root) const {
     root.append(n);
   }
 }
+
+void ConfigVector::dumpToJsonWriter(ConfigJsonWriter &writer) const {
+  // same rule as the jsoncpp styled writer
+  bool singleLine = false;
+  if(writer.isPretty() && !empty()) {
+    size_t length = 4 + (size() - 1) * 2;
+    singleLine = true;
+    for(const ConfigItem &item : *this) {
+      if(!item.isAtom()) {
+        singleLine = false;
+        break;
+      }
+      length += item.toString().size() + 2;
+    }
+    singleLine = singleLine && length < ConfigJsonWriter::LINE_WIDTH;
+  }
+  writer.beginVector(singleLine);
+  for(const ConfigItem &item : *this) {
+    item.dumpToJsonWriter(writer);
+  }
+  writer.endVector();
+}
+
+void ConfigVector::dumpToBinaryWriter(ConfigBinaryWriter &writer) const {
+  writer.beginVector(size());
+  for(const ConfigItem &item : *this) {
+    item.dumpToBinaryWriter(writer);
+  }
+  writer.endVector();
+}
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 
 #include "ConfigItem.hpp"
 #include "ConfigBase.hpp"
@@ -42,12 +43,35 @@ namespace Json {
 
 namespace configmaps {
 
-  class ConfigVector : public ConfigBase,
+  class ConfigVector : public ConfigContainer,
                        public std::vector<ConfigItem> {
   public:
 
-    ConfigVector(std::string s) : ConfigBase(s) {}
-    ConfigVector() {}
+    /**
+     * @brief Kept for compatibility, the name is not stored anymore.
+     * @see ConfigBase::getPath()
+     */
+    ConfigVector(std::string) : ConfigContainer(VECTOR_NODE) {}
+    ConfigVector() : ConfigContainer(VECTOR_NODE) {}
+    ConfigVector(const ConfigVector &other)
+      : ConfigContainer(other), std::vector<ConfigItem>(other) {
+      adoptItems();
+    }
+    ConfigVector(ConfigVector &&other) noexcept
+      : ConfigContainer(std::move(other)),
+        std::vector<ConfigItem>(std::move(other)) {
+      adoptItems();
+    }
+    ConfigVector& operator=(const ConfigVector &other) {
+      std::vector<ConfigItem>::operator=(other);
+      adoptItems();
+      return *this;
+    }
+    ConfigVector& operator=(ConfigVector &&other) noexcept {
+      std::vector<ConfigItem>::operator=(std::move(other));
+      adoptItems();
+      return *this;
+    }
     /**
      * @brief Create and fill the object with values from given YAML::Node.
      * @param n The YAML::Node containing the serialized data for this object.
@@ -62,19 +86,101 @@ namespace configmaps {
 
     size_t append(const ConfigItem &item) {
       this->push_back(item);
-      this->back().setParentName(parentName);
       return this->size() - 1;
     }
 
+    size_t append(ConfigItem &&item) {
+      this->push_back(std::move(item));
+      return this->size() - 1;
+    }
+
+    /*
+     * The modifiers of std::vector that add or relocate items are
+     * wrapped to set this vector as parent of the new and moved items,
+     * a moved item does not keep its parent.
+     */
+    void push_back(const ConfigItem &item) {
+      const ConfigItem *data = this->data();
+      std::vector<ConfigItem>::push_back(item);
+      adoptItems(data, this->size() - 1);
+    }
+
+    void push_back(ConfigItem &&item) {
+      const ConfigItem *data = this->data();
+      std::vector<ConfigItem>::push_back(std::move(item));
+      adoptItems(data, this->size() - 1);
+    }
+
+    template <typename... Args>
+    ConfigItem& emplace_back(Args&&... args) {
+      const ConfigItem *data = this->data();
+      std::vector<ConfigItem>::emplace_back(std::forward<Args>(args)...);
+      adoptItems(data, this->size() - 1);
+      return this->back();
+    }
+
+    template <typename... Args>
+    iterator insert(const_iterator pos, Args&&... args) {
+      iterator it = std::vector<ConfigItem>::insert(pos, std::forward<Args>(args)...);
+      adoptItems();
+      return it;
+    }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+      iterator it = std::vector<ConfigItem>::emplace(pos, std::forward<Args>(args)...);
+      adoptItems();
+      return it;
+    }
+
+    void reserve(size_t n) {
+      const ConfigItem *data = this->data();
+      std::vector<ConfigItem>::reserve(n);
+      adoptItems(data, this->size());
+    }
+
+    void resize(size_t n) {
+      const ConfigItem *data = this->data();
+      size_t oldSize = this->size();
+      std::vector<ConfigItem>::resize(n);
+      adoptItems(data, oldSize);
+    }
+
+    void resize(size_t n, const ConfigItem &item) {
+      const ConfigItem *data = this->data();
+      size_t oldSize = this->size();
+      std::vector<ConfigItem>::resize(n, item);
+      adoptItems(data, oldSize);
+    }
+
+    void shrink_to_fit() {
+      std::vector<ConfigItem>::shrink_to_fit();
+      adoptItems();
+    }
+
+    void swap(ConfigVector &other) {
+      std::vector<ConfigItem>::swap(other);
+      adoptItems();
+      other.adoptItems();
+    }
+
     ConfigVector& operator<<(const ConfigItem &item) {
-      this->push_back(item);
-      this->back().setParentName(parentName);
+      append(item);
+      return *this;
+    }
+
+    ConfigVector& operator<<(ConfigItem &&item) {
+      append(std::move(item));
       return *this;
     }
 
     ConfigVector& operator+=(const ConfigItem &item) {
-      this->push_back(item);
-      this->back().setParentName(parentName);
+      append(item);
+      return *this;
+    }
+
+    ConfigVector& operator+=(ConfigItem &&item) {
+      append(std::move(item));
       return *this;
     }
 
@@ -90,6 +196,33 @@ namespace configmaps {
      */
     virtual void dumpToJsonValue(Json::Value &root) const;
 
+    /**
+     * @brief Writes the JSON array of this vector, short vectors of atoms
+     * are put on one line in pretty mode.
+     */
+    virtual void dumpToJsonWriter(ConfigJsonWriter &writer) const override;
+
+    virtual void dumpToBinaryWriter(ConfigBinaryWriter &writer) const override;
+
+  private:
+    // sets this vector as parent of all items
+    void adoptItems() {
+      for(ConfigItem &item : *this) {
+        item.setParent(this);
+      }
+    }
+
+    // sets this vector as parent of the items from index first on, or of
+    // all items if the storage moved away from data
+    void adoptItems(const ConfigItem *data, size_t first) {
+      if(this->data() != data) {
+        first = 0;
+      }
+      for(size_t i = first; i < this->size(); ++i) {
+        (*this)[i].setParent(this);
+      }
+    }
+
   }; // end of class ConfigVector
 
 } // end of namespace configmaps
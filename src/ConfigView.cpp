@@ -0,0 +1,307 @@
+#include "ConfigView.hpp"
+#include "ConfigItem.hpp"
+#include "ConfigBinary.hpp"
+#include <unordered_map>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace configmaps;
+
+struct ConfigView::Document {
+  const char *data;
+  size_t size;
+  // the mapped file or the data held in memory
+  void *mapping;
+  std::string buffer;
+  std::vector<std::string_view> keys;
+  std::unordered_map<std::string_view, uint64_t> keyIndex;
+
+  Document() : data(NULL), size(0), mapping(NULL) {}
+
+  ~Document() {
+#ifndef _WIN32
+    if(mapping) {
+      munmap(mapping, size);
+    }
+#endif
+  }
+};
+
+ConfigView::ConfigView() : pos(NULL), limit(NULL) {
+}
+
+ConfigView::ConfigView(std::shared_ptr<const Document> document,
+                       const char *pos, const char *limit)
+  : document(std::move(document)), pos(pos), limit(limit) {
+}
+
+ConfigView ConfigView::open(const std::string &filename) {
+  std::shared_ptr<Document> document = std::make_shared<Document>();
+#ifndef _WIN32
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw std::runtime_error("Failed to open File: " + filename);
+  }
+  struct stat info;
+  if(fstat(fd, &info) || info.st_size == 0) {
+    ::close(fd);
+    throw std::runtime_error("Failed to map File: " + filename);
+  }
+  void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(mapping == MAP_FAILED) {
+    throw std::runtime_error("Failed to map File: " + filename);
+  }
+  document->mapping = mapping;
+  document->data = (const char*)mapping;
+  document->size = info.st_size;
+#else
+  std::ifstream fin(filename.c_str(), std::ios::binary);
+  if(fin.fail()) {
+    throw std::runtime_error("Failed to open File: " + filename);
+  }
+  document->buffer.assign(std::istreambuf_iterator<char>(fin),
+                          std::istreambuf_iterator<char>());
+  document->data = document->buffer.data();
+  document->size = document->buffer.size();
+#endif
+  return openDocument(std::move(document));
+}
+
+ConfigView ConfigView::fromBinary(std::string data) {
+  std::shared_ptr<Document> document = std::make_shared<Document>();
+  document->buffer = std::move(data);
+  document->data = document->buffer.data();
+  document->size = document->buffer.size();
+  return openDocument(std::move(document));
+}
+
+ConfigView ConfigView::openDocument(std::shared_ptr<Document> document) {
+  const char *rootEnd;
+  const char *root = ConfigBinaryReader::readHeader(document->data,
+                                                    document->size,
+                                                    document->keys, rootEnd);
+  if(root == rootEnd) {
+    ConfigBinaryReader::fail("missing root value");
+  }
+  document->keyIndex.reserve(document->keys.size());
+  for(size_t i = 0; i < document->keys.size(); ++i) {
+    document->keyIndex.emplace(document->keys[i], i);
+  }
+  return ConfigView(std::move(document), root, rootEnd);
+}
+
+unsigned char ConfigView::tag() const {
+  if(!pos) {
+    return ConfigBinaryWriter::EMPTY_TAG;
+  }
+  return *pos & ~ConfigBinaryWriter::INFERRED_FLAG;
+}
+
+bool ConfigView::isAtom() const {
+  unsigned char t = tag();
+  return t != ConfigBinaryWriter::EMPTY_TAG && t != ConfigBinaryWriter::MAP_TAG &&
+    t != ConfigBinaryWriter::VECTOR_TAG;
+}
+
+bool ConfigView::isMap() const {
+  return tag() == ConfigBinaryWriter::MAP_TAG;
+}
+
+bool ConfigView::isVector() const {
+  return tag() == ConfigBinaryWriter::VECTOR_TAG;
+}
+
+bool ConfigView::isEmpty() const {
+  return tag() == ConfigBinaryWriter::EMPTY_TAG;
+}
+
+uint64_t ConfigView::readContainer(const char *&table, const char *&first,
+                                   const char *&last) const {
+  const char *p = pos + 1;
+  uint64_t length = ConfigBinaryReader::readFixed(p, limit, 4);
+  if(length > (uint64_t)(limit - p)) {
+    ConfigBinaryReader::fail("truncated container");
+  }
+  last = p + length;
+  uint64_t count = ConfigBinaryReader::readVarint(p, last);
+  size_t width = isMap() ? ConfigBinaryWriter::MAP_TABLE_ENTRY :
+    ConfigBinaryWriter::VECTOR_TABLE_ENTRY;
+  if(count > (uint64_t)(last - p) / (width + 1)) {
+    ConfigBinaryReader::fail("bad element count");
+  }
+  table = p;
+  first = p + count * width;
+  return count;
+}
+
+// Reads the offset of an entry from the entry table at slot.
+static const char* entryAt(const char *slot, const char *first,
+                           const char *last) {
+  uint64_t offset = ConfigBinaryReader::readFixed(slot, first, 4);
+  if(offset >= (uint64_t)(last - first)) {
+    ConfigBinaryReader::fail("bad entry offset");
+  }
+  return first + offset;
+}
+
+ConfigView ConfigView::child(const char *p, const char *last) const {
+  // a map entry might end behind its key
+  if(p == last) {
+    ConfigBinaryReader::fail("truncated value");
+  }
+  return ConfigView(document, p, last);
+}
+
+size_t ConfigView::size() const {
+  if(isMap() || isVector()) {
+    const char *table, *first, *last;
+    return readContainer(table, first, last);
+  }
+  return isAtom() ? 1 : 0;
+}
+
+// Map entries refer to keys by index, so the key is looked up once and
+// the index is searched in the entry table, which is sorted by it.
+bool ConfigView::find(std::string_view key, ConfigView &value) const {
+  if(!isMap()) {
+    return false;
+  }
+  std::unordered_map<std::string_view, uint64_t>::const_iterator it =
+    document->keyIndex.find(key);
+  if(it == document->keyIndex.end()) {
+    return false;
+  }
+  const char *table, *first, *last;
+  uint64_t low = 0, high = readContainer(table, first, last);
+  while(low < high) {
+    uint64_t middle = low + (high - low) / 2;
+    const char *slot = table + middle * ConfigBinaryWriter::MAP_TABLE_ENTRY;
+    uint64_t index = ConfigBinaryReader::readFixed(slot, first, 4);
+    if(index < it->second) {
+      low = middle + 1;
+    } else if(index > it->second) {
+      high = middle;
+    } else {
+      const char *p = entryAt(slot, first, last);
+      if(ConfigBinaryReader::readVarint(p, last) != index) {
+        ConfigBinaryReader::fail("bad entry table");
+      }
+      value = child(p, last);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ConfigView::hasKey(std::string_view key) const {
+  ConfigView value;
+  return find(key, value);
+}
+
+ConfigView ConfigView::operator[](std::string_view key) const {
+  if(!isMap()) {
+    throw std::runtime_error("ConfigView: no map to look up \"" +
+                             std::string(key) + "\"");
+  }
+  ConfigView value;
+  if(!find(key, value)) {
+    throw std::runtime_error("ConfigView: key \"" + std::string(key) +
+                             "\" not found");
+  }
+  return value;
+}
+
+ConfigView ConfigView::operator[](size_t index) const {
+  if(!isVector()) {
+    throw std::runtime_error("ConfigView: no vector to index");
+  }
+  const char *table, *first, *last;
+  if(index >= readContainer(table, first, last)) {
+    throw std::runtime_error("ConfigView: index " + std::to_string(index) +
+                             " out of range");
+  }
+  const char *slot = table + index * ConfigBinaryWriter::VECTOR_TABLE_ENTRY;
+  return child(entryAt(slot, first, last), last);
+}
+
+ConfigView::const_iterator ConfigView::begin() const {
+  if(!isMap() && !isVector()) {
+    return const_iterator();
+  }
+  const char *table, *first, *last;
+  readContainer(table, first, last);
+  return const_iterator(*this, first, last);
+}
+
+ConfigView::const_iterator ConfigView::end() const {
+  if(!isMap() && !isVector()) {
+    return const_iterator();
+  }
+  const char *table, *first, *last;
+  readContainer(table, first, last);
+  return const_iterator(*this, last, last);
+}
+
+ConfigAtom ConfigView::getAtom() const {
+  if(!isAtom()) {
+    throw std::runtime_error("ConfigView: value is no atom");
+  }
+  ConfigAtom atom;
+  const char *p = pos + 1;
+  ConfigBinaryReader::readAtom(*pos, p, limit, atom);
+  return atom;
+}
+
+ConfigItem ConfigView::toItem() const {
+  ConfigItem item;
+  if(pos) {
+    const char *p = pos;
+    ConfigBinaryReader::readValue(p, limit, document->keys, item);
+  }
+  return item;
+}
+
+ConfigView::const_iterator::const_iterator(const ConfigView &container,
+                                           const char *first,
+                                           const char *last)
+  : pos(first), last(last), isMap(container.isMap()) {
+  entry.second.document = container.document;
+  entry.second.limit = last;
+  decode();
+}
+
+void ConfigView::const_iterator::decode() {
+  if(pos == last) {
+    entry.first = std::string_view();
+    entry.second.pos = NULL;
+    return;
+  }
+  const char *p = pos;
+  if(isMap) {
+    uint64_t index = ConfigBinaryReader::readVarint(p, last);
+    if(index >= entry.second.document->keys.size()) {
+      ConfigBinaryReader::fail("bad key index");
+    }
+    entry.first = entry.second.document->keys[index];
+    if(p == last) {
+      ConfigBinaryReader::fail("truncated value");
+    }
+  }
+  entry.second.pos = p;
+}
+
+ConfigView::const_iterator& ConfigView::const_iterator::operator++() {
+  pos = entry.second.pos;
+  ConfigBinaryReader::skipValue(pos, last);
+  decode();
+  return *this;
+}
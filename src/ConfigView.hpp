@@ -0,0 +1,235 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <iterator>
+#include "ConfigAtom.hpp"
+
+namespace configmaps {
+
+  class ConfigItem;
+
+  /**
+   * @brief Read-only view into a binary document, navigated in place.
+   *
+   * A document written by toBinaryFile() is mapped into memory by open(),
+   * the pages are shared between all processes that open the same file.
+   * Views decode values on access instead of building ConfigItems, only
+   * the key table is indexed when the document is opened. Keys and indices
+   * are looked up in the entry tables of the containers, in O(log n) and
+   * O(1). Every view keeps the document alive.
+   *
+   * Typed getters behave like the ones of ConfigAtom, e.g. unparsed text
+   * is parsed on each access.
+   */
+  class ConfigView {
+  public:
+    struct Entry;
+    class const_iterator;
+
+    /**
+     * @brief Maps the binary file into memory.
+     * @throw std::runtime_error if the file can not be mapped or has no
+     * valid header.
+     */
+    static ConfigView open(const std::string &filename);
+
+    /**
+     * @brief Views a document held in memory, the view keeps the data.
+     */
+    static ConfigView fromBinary(std::string data);
+
+    // an empty view, as of an item without node
+    ConfigView();
+
+    bool isAtom() const;
+    bool isMap() const;
+    bool isVector() const;
+    bool isEmpty() const;
+
+    /**
+     * @brief Entries of a map or vector, 1 for atoms.
+     */
+    size_t size() const;
+
+    bool hasKey(std::string_view key) const;
+
+    /**
+     * @throw std::runtime_error if this is no map or the key is missing.
+     */
+    ConfigView operator[](std::string_view key) const;
+    ConfigView operator[](const char *key) const {
+      return (*this)[std::string_view(key)];
+    }
+    ConfigView operator[](const std::string &key) const {
+      return (*this)[std::string_view(key)];
+    }
+
+    /**
+     * @throw std::runtime_error if this is no vector or the index is out
+     * of range.
+     */
+    ConfigView operator[](size_t index) const;
+    ConfigView operator[](int index) const {
+      return (*this)[(size_t)index];
+    }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief Decodes this atom.
+     * @throw std::runtime_error if this is no atom.
+     */
+    ConfigAtom getAtom() const;
+
+    ConfigAtom::ItemType getType() const {
+      return getAtom().getType();
+    }
+
+    int getInt() const {
+      return getAtom().getInt();
+    }
+
+    unsigned int getUInt() const {
+      return getAtom().getUInt();
+    }
+
+    unsigned long getULong() const {
+      return getAtom().getULong();
+    }
+
+    double getDouble() const {
+      return getAtom().getDouble();
+    }
+
+    bool getBool() const {
+      return getAtom().getBool();
+    }
+
+    std::string getString() const {
+      return getAtom().getString();
+    }
+
+    operator int () const {
+      return getInt();
+    }
+
+    operator unsigned int () const {
+      return getUInt();
+    }
+
+    operator unsigned long () const {
+      return getULong();
+    }
+
+    operator double () const {
+      return getDouble();
+    }
+
+    operator bool () const {
+      return getBool();
+    }
+
+    operator std::string () const {
+      return getString();
+    }
+
+    // returns the value of the key or the default value if it is missing
+    template<typename T> T get(std::string_view key,
+                               const T &defaultValue) const {
+      ConfigView value;
+      if(find(key, value)) {
+        return (T)value;
+      }
+      return defaultValue;
+    }
+
+    /**
+     * @brief Decodes the viewed subtree into a ConfigItem.
+     */
+    ConfigItem toItem() const;
+
+  private:
+    struct Document;
+
+    std::shared_ptr<const Document> document;
+    // the tag of the value, NULL for empty views
+    const char *pos;
+    // the end of the enclosing container
+    const char *limit;
+
+    ConfigView(std::shared_ptr<const Document> document, const char *pos,
+               const char *limit);
+
+    static ConfigView openDocument(std::shared_ptr<Document> document);
+
+    unsigned char tag() const;
+    // reads the header of a map or vector, table is set to its entry table
+    // and first to its first entry
+    uint64_t readContainer(const char *&table, const char *&first,
+                           const char *&last) const;
+    // the view of the value at p, the end of the container is last
+    ConfigView child(const char *p, const char *last) const;
+    bool find(std::string_view key, ConfigView &value) const;
+  }; // end of class ConfigView
+
+  struct ConfigView::Entry {
+    // the key of map entries, empty for vector elements
+    std::string_view first;
+    ConfigView second;
+  };
+
+  /**
+   * @brief Iterates over the entries of a map or the elements of a vector.
+   */
+  class ConfigView::const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ConfigView::Entry value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const ConfigView::Entry* pointer;
+    typedef const ConfigView::Entry& reference;
+
+    const_iterator() : pos(NULL), last(NULL), isMap(false) {}
+
+    reference operator*() const {
+      return entry;
+    }
+
+    pointer operator->() const {
+      return &entry;
+    }
+
+    const_iterator& operator++();
+
+    const_iterator operator++(int) {
+      const_iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return pos == other.pos;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return pos != other.pos;
+    }
+
+  private:
+    friend class ConfigView;
+
+    Entry entry;
+    // the start of the current entry
+    const char *pos;
+    const char *last;
+    bool isMap;
+
+    const_iterator(const ConfigView &container, const char *first,
+                   const char *last);
+    void decode();
+  }; // end of class ConfigView::const_iterator
+
+} // end of namespace configmaps
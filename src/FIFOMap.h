@@ -25,57 +25,226 @@
 #warning "FIFOMap.h"
 #endif
 
-#include <map>
-#include <list>
-#include <iterator>
-#include <iostream>
+#include <vector>
 #include <algorithm>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <iterator>
+#include <functional>
+#include <type_traits>
 #include <utility>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
 
 namespace configmaps {
 
     template <typename Key, typename T>
-    class FIFOItem {
-    public:
-      FIFOItem(const Key &k, T &val)
-        : first(k), second(val)
+    using FIFOItem = std::pair<const Key, T>;
+
+    template <typename Key, typename T>
+    class FIFOMap;
+
+    /**
+     * @brief Hash used by FIFOMap.
+     *
+     * String keys are hashed as std::string_view, which allows to look
+     * them up by string_view or literal without creating a std::string.
+     */
+    template <typename Key>
+    struct FIFOHash {
+      size_t operator()(const Key &key) const
+      { return std::hash<Key>()(key); }
+    };
+
+    template <>
+    struct FIFOHash<std::string> {
+      size_t operator()(std::string_view key) const
+      { return std::hash<std::string_view>()(key); }
+    };
+
+    /**
+     * @brief Element of the dense FIFOMap storage.
+     *
+     * Erased entries are only marked as dead and stay in place until the
+     * next rehash, so the positions of all other entries are kept.
+     */
+    template <typename Key, typename T>
+    struct FIFOEntry {
+      template <typename K, typename... Args>
+      FIFOEntry(size_t h, K &&k, Args&&... args)
+        : item(std::piecewise_construct,
+               std::forward_as_tuple(std::forward<K>(k)),
+               std::forward_as_tuple(std::forward<Args>(args)...)),
+          hash(h), live(true)
       {}
-      bool operator==(const FIFOItem &other) const {
-        return first == other.first;
+
+      FIFOItem<Key, T> item;
+      size_t hash;
+      bool live;
+    }; // end of struct FIFOEntry
+
+    /**
+     * @brief Iterates the live entries of a FIFOMap in insertion order.
+     *
+     * The iterator stores a position in the entry storage and not a
+     * pointer to the entry. Thus it stays valid while other keys are
+     * erased, e.g. in the loop "m.erase(it++)", and while new keys are
+     * added as long as that does not rehash the map, see FIFOMap. Every
+     * position behind the last entry compares equal to end().
+     */
+    template <typename Key, typename T, typename Value>
+    class FIFOIterator {
+    public:
+      typedef std::bidirectional_iterator_tag iterator_category;
+      typedef typename std::remove_const<Value>::type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef Value* pointer;
+      typedef Value& reference;
+      typedef typename std::conditional<std::is_const<Value>::value,
+                                        const FIFOMap<Key, T>,
+                                        FIFOMap<Key, T> >::type Map;
+
+      FIFOIterator() : map(NULL), pos(0) {}
+      FIFOIterator(Map *m, size_t p) : map(m), pos(p) {}
+
+      // allows the conversion from iterator to const_iterator
+      template <typename Other,
+                typename = typename std::enable_if<std::is_convertible<Other*, Value*>::value>::type>
+      FIFOIterator(const FIFOIterator<Key, T, Other> &other)
+        : map(other.map), pos(other.pos) {}
+
+      reference operator*() const
+      { return map->entryAt(pos).item; }
+      pointer operator->() const
+      { return &map->entryAt(pos).item; }
+
+      FIFOIterator& operator++()
+      { pos = map->nextLive(pos); return *this; }
+      FIFOIterator operator++(int)
+      { FIFOIterator tmp(*this); ++*this; return tmp; }
+      FIFOIterator& operator--()
+      { pos = map->prevLive(pos); return *this; }
+      FIFOIterator operator--(int)
+      { FIFOIterator tmp(*this); --*this; return tmp; }
+
+      template <typename Other>
+      bool operator==(const FIFOIterator<Key, T, Other> &other) const {
+        return map == other.map &&
+          (pos == other.pos || (atEnd() && other.atEnd()));
       }
+      template <typename Other>
+      bool operator!=(const FIFOIterator<Key, T, Other> &other) const
+      { return !(*this == other); }
+
+    private:
+      template <typename K, typename V, typename O> friend class FIFOIterator;
+      friend class FIFOMap<Key, T>;
 
-      Key first;
-      T &second;
-    }; // end of class FIFOItem
+      Map *map;
+      size_t pos;
 
+      // erasing the last entries shrinks the storage behind the iterator
+      bool atEnd() const
+      { return !map || pos >= map->usedEntries; }
+    }; // end of class FIFOIterator
+
+
+    /**
+     * @brief Map that keeps the insertion order of its keys.
+     *
+     * The storage follows the layout of CPython's compact dict: the
+     * entries (hash, key and value) are kept densely in insertion order
+     * and an open addressing table of entry positions is used for the
+     * lookup. The entries are allocated in segments of growing size, so
+     * adding keys never moves existing entries and references to values
+     * stay valid until the key is erased.
+     *
+     * Erasing a key only marks its entry as dead, erasing never moves
+     * entries. Dead entries at the end of the storage are dropped right
+     * away, e.g. when the map becomes empty. Like CPython, the lookup
+     * table is rebuilt when adding a key fills it up, and if dead entries
+     * outnumber the live ones then, the live entries are moved to the
+     * front of the storage. Thus a rehash by insert() or reserve()
+     * invalidates iterators and references, see relocated().
+     *
+     * Apart from the insertion order the map follows std::map. As the
+     * keys are not sorted, lower_bound(), upper_bound(), equal_range()
+     * and key_comp() are not provided. rbegin() iterates the keys in
+     * reverse insertion order.
+     */
     template <typename Key, typename T>
-    class FIFOMap : public std::map<Key, T> {
+    class FIFOMap {
     public:
-      typedef typename std::map<Key, T>::iterator mapIterator;
-      typedef typename std::map<Key, T>::const_iterator const_mapIterator;
-      typedef typename std::list<FIFOItem<Key, T> >::iterator iterator;
-      typedef typename std::list<FIFOItem<Key, T> >::const_iterator const_iterator;
+      typedef Key key_type;
+      typedef T mapped_type;
+      typedef FIFOItem<Key, T> value_type;
+      typedef FIFOIterator<Key, T, value_type> iterator;
+      typedef FIFOIterator<Key, T, const value_type> const_iterator;
+      typedef std::reverse_iterator<iterator> reverse_iterator;
+      typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
       /* iterator stuff */
       iterator begin()
-      { return insertOrder.begin(); }
+      { return iterator(this, nextLive(npos)); }
       const_iterator begin() const
-      { return insertOrder.begin(); }
+      { return const_iterator(this, nextLive(npos)); }
       iterator end()
-      { return insertOrder.end(); }
+      { return iterator(this, usedEntries); }
       const_iterator end() const
-      { return insertOrder.end(); }
+      { return const_iterator(this, usedEntries); }
+      reverse_iterator rbegin()
+      { return reverse_iterator(end()); }
+      const_reverse_iterator rbegin() const
+      { return const_reverse_iterator(end()); }
+      reverse_iterator rend()
+      { return reverse_iterator(begin()); }
+      const_reverse_iterator rend() const
+      { return const_reverse_iterator(begin()); }
 
       /* ctor, copy-ctor and assignment operator */
-      FIFOMap() {}
+      FIFOMap() : usedEntries(0), liveEntries(0), deletedSlots(0) {}
       FIFOMap(const FIFOMap<Key, T> &other)
+        : usedEntries(0), liveEntries(0), deletedSlots(0)
       { *this = other; }
+      FIFOMap(FIFOMap<Key, T> &&other) noexcept
+        : usedEntries(0), liveEntries(0), deletedSlots(0)
+      { swap(other); }
       FIFOMap<Key, T>& operator=(const FIFOMap<Key, T> &other);
-      virtual ~FIFOMap(){};
+      FIFOMap<Key, T>& operator=(FIFOMap<Key, T> &&other) noexcept {
+        if(this != &other) {
+          clear();
+          swap(other);
+        }
+        return *this;
+      }
+      virtual ~FIFOMap()
+      { clear(); }
+
+    protected:
+      /**
+       * @brief Called after a rehash moved the entries.
+       *
+       * Derived maps update what refers to the addresses of the values.
+       */
+      virtual void relocated() {}
+
+    public:
+
+      /* capacity */
+      size_t size() const
+      { return liveEntries; }
+      bool empty() const
+      { return liveEntries == 0; }
+      void reserve(size_t n);
 
       /* element access */
       T& operator[](const Key &x);
+      template <typename K>
+      T& at(const K &x);
+      template <typename K>
+      const T& at(const K &x) const;
 
       /* modifieres */
       std::pair<iterator, bool> insert(const std::pair<const Key, T> &x);
@@ -84,41 +253,47 @@ namespace configmaps {
          iterator insert(iterator position, const value_type &x);
          template <class InputIterator>
          void insert ( InputIterator first, InputIterator last );
-         emplace
       */
-//    template <class... Args>
-//      std::pair<iterator,bool> emplace (Args&&... args){
-#if __cplusplus > 199711L
       virtual std::pair<iterator,bool> emplace (Key &key, T value){
-          std::pair<mapIterator, bool> tmp;
-          tmp = std::map<Key, T>::emplace(key, value);
-          if(tmp.second){
-              insertOrder.push_back(FIFOItem<Key, T>(tmp.first->first, tmp.first->second));
-              return std::make_pair(--insertOrder.end(), true);
-          }else{
-              for(iterator it = insertOrder.begin(); it != insertOrder.end(); it++ ){
-                  if(it->first == tmp.first->first){
-                      return std::make_pair(it, false);
-                  }
-              }
-              throw std::runtime_error("FIFO Map structure corrupted, key was found in the map but not in the key list");
-          }
+        std::pair<size_t, bool> tmp = tryEmplace(key, std::move(value));
+        return std::make_pair(iterator(this, tmp.first), tmp.second);
       }
-#endif
-    
+
+      /**
+       * Inserts a value constructed from args if the key is not in the map
+       * yet. The key is only converted to Key if it is inserted, thus it
+       * can be given as any type that FIFOHash accepts.
+       */
+      template <typename K, typename... Args>
+      std::pair<iterator, bool> try_emplace(K &&key, Args&&... args) {
+        std::pair<size_t, bool> tmp = tryEmplace(std::forward<K>(key),
+                                                 std::forward<Args>(args)...);
+        return std::make_pair(iterator(this, tmp.first), tmp.second);
+      }
+
+      /**
+       * Erasing keys only marks their entries as dead. Iterators and
+       * references to the other keys stay valid.
+       */
       void erase(iterator position);
-      size_t erase(const Key &x);
+      template <typename K>
+      size_t erase(const K &x);
       void erase(iterator first, iterator last);
-      void swap( FIFOMap<Key, T> &other);
+      void swap( FIFOMap<Key, T> &other) noexcept;
       void clear();
 
       void append(FIFOMap<Key, T> &other);
       void append(const FIFOMap<Key, T> &other);
+      void append(FIFOMap<Key, T> &&other);
 
-      /* operations */
-      iterator find(const Key &x);
-      const_iterator find(const Key &x) const
-      { return const_iterator(const_cast<FIFOMap*>(this)->find(x)); }
+      /* operations, keys can be given as any type FIFOHash accepts */
+      template <typename K>
+      iterator find(const K &x);
+      template <typename K>
+      const_iterator find(const K &x) const;
+      template <typename K>
+      size_t count(const K &x) const
+      { return lookup(x, FIFOHash<Key>()(x)) != npos; }
 
       /* not implemented yet;
          iterator lower_bound ( const key_type& x );
@@ -130,7 +305,60 @@ namespace configmaps {
       */
 
     private:
-      std::list<FIFOItem<Key, T> > insertOrder;
+      template <typename K, typename V, typename O> friend class FIFOIterator;
+      typedef FIFOEntry<Key, T> Entry;
+
+      static constexpr size_t npos = static_cast<size_t>(-1);
+      // markers of the lookup table
+      static constexpr uint32_t EMPTY_SLOT = 0xffffffffu;
+      static constexpr uint32_t DELETED_SLOT = 0xfffffffeu;
+      // size of the first storage segment, segment n holds
+      // MIN_SEGMENT << n entries
+      static constexpr size_t MIN_SEGMENT = 4;
+
+      std::vector<Entry*> segments;
+      std::vector<uint32_t> index;
+      size_t usedEntries;  // constructed entries including dead ones
+      size_t liveEntries;
+      size_t deletedSlots; // DELETED_SLOT markers in the index
+
+      static size_t segmentOf(size_t pos) {
+        size_t n = (pos / MIN_SEGMENT) + 1;
+#if defined(__GNUC__)
+        return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(n);
+#else
+        size_t segment = 0;
+        while(n >>= 1) ++segment;
+        return segment;
+#endif
+      }
+
+      Entry& entryAt(size_t pos) {
+        size_t segment = segmentOf(pos);
+        return segments[segment][pos - MIN_SEGMENT * ((size_t(1) << segment) - 1)];
+      }
+      const Entry& entryAt(size_t pos) const
+      { return const_cast<FIFOMap*>(this)->entryAt(pos); }
+
+      size_t nextLive(size_t pos) const {
+        for(++pos; pos < usedEntries && !entryAt(pos).live; ++pos);
+        return pos;
+      }
+      size_t prevLive(size_t pos) const {
+        pos = std::min(pos, usedEntries);
+        for(--pos; pos > 0 && !entryAt(pos).live; --pos);
+        return pos;
+      }
+
+      template <typename K>
+      size_t lookup(const K &key, size_t hash) const;
+      template <typename K, typename... Args>
+      std::pair<size_t, bool> tryEmplace(K &&key, Args&&... args);
+      void eraseAt(size_t pos);
+      void allocateEntries(size_t n);
+      void rebuildIndex(size_t minEntries);
+      void compactEntries();
+      void destroyEntries();
 
     }; // end of class FIFOMap
 
@@ -144,85 +372,84 @@ namespace configmaps {
       if(this == &other)
         return *this;
       clear();
-      std::map<Key, T>::operator=(other);
+      reserve(other.size());
       for(const_iterator it = other.begin(); it != other.end(); ++it) {
-        FIFOItem<Key, T> newItem(it->first, 
-                                 std::map<Key, T>::operator[](it->first));
-        insertOrder.push_back(newItem);
+        tryEmplace(it->first, it->second);
       }
       return *this;
     }
 
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::reserve(size_t n) {
+      allocateEntries(usedEntries - liveEntries + n);
+      if(index.size() * 2 < (n + deletedSlots) * 3) {
+        rebuildIndex(n);
+      }
+    }
+
     /* element access */
     template<typename Key, typename T>
     T& FIFOMap<Key, T>::operator[](const Key &x) {
-      mapIterator it = std::map<Key, T>::find(x);
-      if(it != std::map<Key, T>::end()) {
-        return it->second;
-      } else {
-        FIFOItem<Key, T> newItem(x, std::map<Key, T>::operator[](x));
-        insertOrder.push_back(newItem);
-        return newItem.second;
+      return entryAt(tryEmplace(x).first).item.second;
+    }
+
+    template<typename Key, typename T>
+    template<typename K>
+    T& FIFOMap<Key, T>::at(const K &x) {
+      size_t pos = lookup(x, FIFOHash<Key>()(x));
+      if(pos == npos) {
+        throw std::out_of_range("FIFOMap::at: key not found");
       }
+      return entryAt(pos).item.second;
+    }
+
+    template<typename Key, typename T>
+    template<typename K>
+    const T& FIFOMap<Key, T>::at(const K &x) const {
+      return const_cast<FIFOMap*>(this)->at(x);
     }
 
     /* modifieres */
     template<typename Key, typename T>
     std::pair<typename FIFOMap<Key, T>::iterator, bool> FIFOMap<Key, T>::insert(const std::pair<const Key, T> &x) {
-      std::cerr << "FIFOMap::insert is untested" << std::endl;
-      mapIterator it = this->find(x.first);
-      if(it != std::map<Key, T>::end()) {
-        return std::make_pair(std::find(insertOrder.begin(), 
-                                        insertOrder.end(), 
-                                        FIFOItem<Key, T>(it->first,
-                                                         it->second)), 
-                              false);
-      } else {
-        std::pair<mapIterator, bool> tmp;
-        tmp = std::map<Key, T>::insert(x);
-        insertOrder.push_back(FIFOItem<Key, T>(x.first, tmp.first->second));
-        return std::make_pair(--insertOrder.end(), true);
-      }
+      std::pair<size_t, bool> tmp = tryEmplace(x.first, x.second);
+      return std::make_pair(iterator(this, tmp.first), tmp.second);
     }
-    
+
     template<typename Key, typename T>
     void FIFOMap<Key, T>::erase(FIFOMap<Key, T>::iterator position) {
-      // seems to work fine
-      // std::cerr << "FIFOMap::erase is untested" << std::endl;
-      std::map<Key, T>::erase(position->first);
-      insertOrder.erase(position);
+      eraseAt(position.pos);
     }
 
     template<typename Key, typename T>
-    size_t FIFOMap<Key, T>::erase(const Key &x) {
-      //std::cerr << "FIFOMap::erase is untested" << std::endl;
-      size_t ret = std::map<Key, T>::erase(x);
-      if(ret) {
-        for(iterator it = begin(); it != end(); ++it) {
-          if(it->first == x) {
-            insertOrder.erase(it);
-            break;
-          }
-        }
+    template<typename K>
+    size_t FIFOMap<Key, T>::erase(const K &x) {
+      size_t pos = lookup(x, FIFOHash<Key>()(x));
+      if(pos == npos) {
+        return 0;
       }
-      return ret;
+      erase(iterator(this, pos));
+      return 1;
     }
 
     template<typename Key, typename T>
     void FIFOMap<Key, T>::erase(FIFOMap::iterator first,
                                 FIFOMap::iterator last) {
-      std::cerr << "FIFOMap::erase is untested" << std::endl;
-      for(iterator it = first; it != last; /* do nothing */) {
-        std::map<Key, T>::erase(it->first);
-        it = insertOrder.erase(it);
+      // positions stay stable, only dead entries at the end of the
+      // storage are dropped by eraseAt
+      for(size_t pos = first.pos; pos < last.pos && pos < usedEntries;
+          pos = nextLive(pos)) {
+        eraseAt(pos);
       }
     }
 
     template<typename Key, typename T>
-    void FIFOMap<Key, T>::swap(FIFOMap<Key, T> &other) {
-      std::cerr << "FIFOMap::swap is untested" << std::endl;
-      std::map<Key, T>::swap(other);
-      insertOrder.swap(other.insertOrder);
+    void FIFOMap<Key, T>::swap(FIFOMap<Key, T> &other) noexcept {
+      segments.swap(other.segments);
+      index.swap(other.index);
+      std::swap(usedEntries, other.usedEntries);
+      std::swap(liveEntries, other.liveEntries);
+      std::swap(deletedSlots, other.deletedSlots);
     }
 
     template<typename Key, typename T>
@@ -243,25 +470,181 @@ namespace configmaps {
       }
     }
 
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::append(FIFOMap<Key, T> &&other) {
+      iterator it = other.begin();
+      for(; it!=other.end(); ++it) {
+        FIFOMap<Key, T>::operator[](it->first) = std::move(it->second);
+      }
+      other.clear();
+    }
+
     template<typename Key, typename T>
     void FIFOMap<Key, T>::clear() {
-      std::map<Key, T>::clear();
-      insertOrder.clear();
+      destroyEntries();
+      std::allocator<Entry> alloc;
+      for(size_t segment = 0; segment < segments.size(); ++segment) {
+        alloc.deallocate(segments[segment], MIN_SEGMENT << segment);
+      }
+      segments.clear();
+      index.clear();
+      deletedSlots = 0;
     }
-    
+
     /* operations */
     template<typename Key, typename T>
-    typename FIFOMap<Key, T>::iterator FIFOMap<Key, T>::find(const Key &x) {
-      typename std::map<Key, T>::iterator it = std::map<Key, T>::find(x);
-      if(it != std::map<Key, T>::end()) {
-        return std::find(insertOrder.begin(), 
-                         insertOrder.end(), 
-                         FIFOItem<Key, T>(it->first, 
-                                          it->second));
-      }
-      return end();
+    template<typename K>
+    typename FIFOMap<Key, T>::iterator FIFOMap<Key, T>::find(const K &x) {
+      size_t pos = lookup(x, FIFOHash<Key>()(x));
+      return pos == npos ? end() : iterator(this, pos);
+    }
+
+    template<typename Key, typename T>
+    template<typename K>
+    typename FIFOMap<Key, T>::const_iterator FIFOMap<Key, T>::find(const K &x) const {
+      size_t pos = lookup(x, FIFOHash<Key>()(x));
+      return pos == npos ? end() : const_iterator(this, pos);
+    }
+
+    /* storage */
+    template<typename Key, typename T>
+    template<typename K>
+    size_t FIFOMap<Key, T>::lookup(const K &key, size_t hash) const {
+      if(index.empty()) {
+        return npos;
+      }
+      size_t mask = index.size() - 1;
+      for(size_t i = hash & mask; index[i] != EMPTY_SLOT; i = (i + 1) & mask) {
+        if(index[i] == DELETED_SLOT) {
+          continue;
+        }
+        const Entry &entry = entryAt(index[i]);
+        if(entry.hash == hash && entry.item.first == key) {
+          return index[i];
+        }
+      }
+      return npos;
+    }
+
+    template<typename Key, typename T>
+    template<typename K, typename... Args>
+    std::pair<size_t, bool> FIFOMap<Key, T>::tryEmplace(K &&key, Args&&... args) {
+      size_t hash = FIFOHash<Key>()(key);
+      if((liveEntries + deletedSlots + 1) * 3 > index.size() * 2) {
+        rebuildIndex(liveEntries + 1);
+      }
+      size_t mask = index.size() - 1;
+      size_t slot = npos;
+      size_t i = hash & mask;
+      for(; index[i] != EMPTY_SLOT; i = (i + 1) & mask) {
+        if(index[i] == DELETED_SLOT) {
+          if(slot == npos) slot = i;
+          continue;
+        }
+        const Entry &entry = entryAt(index[i]);
+        if(entry.hash == hash && entry.item.first == key) {
+          return std::make_pair((size_t)index[i], false);
+        }
+      }
+      if(slot == npos) {
+        slot = i;
+      } else {
+        --deletedSlots;
+      }
+      if(usedEntries >= DELETED_SLOT) {
+        throw std::length_error("FIFOMap: too many entries");
+      }
+      allocateEntries(usedEntries + 1);
+      new (&entryAt(usedEntries)) Entry(hash, std::forward<K>(key),
+                                        std::forward<Args>(args)...);
+      index[slot] = (uint32_t)usedEntries;
+      ++liveEntries;
+      return std::make_pair(usedEntries++, true);
+    }
+
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::eraseAt(size_t pos) {
+      Entry &entry = entryAt(pos);
+      size_t mask = index.size() - 1;
+      size_t i = entry.hash & mask;
+      while(index[i] != pos) {
+        i = (i + 1) & mask;
+      }
+      index[i] = DELETED_SLOT;
+      ++deletedSlots;
+      entry.live = false;
+      entry.item.second = T();
+      --liveEntries;
+      // dead entries at the end can be dropped right away
+      while(usedEntries > 0 && !entryAt(usedEntries - 1).live) {
+        entryAt(--usedEntries).~Entry();
+      }
+    }
+
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::allocateEntries(size_t n) {
+      size_t capacity = MIN_SEGMENT * ((size_t(1) << segments.size()) - 1);
+      std::allocator<Entry> alloc;
+      while(capacity < n) {
+        segments.push_back(alloc.allocate(MIN_SEGMENT << segments.size()));
+        capacity = MIN_SEGMENT * ((size_t(1) << segments.size()) - 1);
+      }
+    }
+
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::rebuildIndex(size_t minEntries) {
+      size_t slots = 8;
+      while(slots < minEntries * 3) {
+        slots <<= 1;
+      }
+      // the dead entries would be walked by every rehash and iteration
+      bool compact = usedEntries - liveEntries > liveEntries;
+      if(compact) {
+        compactEntries();
+      }
+      index.assign(slots, EMPTY_SLOT);
+      deletedSlots = 0;
+      size_t mask = slots - 1;
+      for(size_t pos = 0; pos < usedEntries; ++pos) {
+        const Entry &entry = entryAt(pos);
+        if(!entry.live) continue;
+        size_t i = entry.hash & mask;
+        while(index[i] != EMPTY_SLOT) {
+          i = (i + 1) & mask;
+        }
+        index[i] = (uint32_t)pos;
+      }
+      if(compact) {
+        relocated();
+      }
+    }
+
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::compactEntries() {
+      size_t used = 0;
+      for(size_t pos = 0; pos < usedEntries; ++pos) {
+        Entry &entry = entryAt(pos);
+        if(!entry.live) {
+          entry.~Entry();
+        } else if(pos != used) {
+          new (&entryAt(used++)) Entry(std::move(entry));
+          entry.~Entry();
+        } else {
+          ++used;
+        }
+      }
+      usedEntries = used;
     }
-    
+
+    template<typename Key, typename T>
+    void FIFOMap<Key, T>::destroyEntries() {
+      for(size_t pos = 0; pos < usedEntries; ++pos) {
+        entryAt(pos).~Entry();
+      }
+      usedEntries = 0;
+      liveEntries = 0;
+    }
+
 } // end of namespace configmaps
 
 #endif /* MARS_UTILS_FIFO_MAP_H */
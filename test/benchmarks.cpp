@@ -0,0 +1,266 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+#include "ConfigMap.hpp"
+#include "ConfigAtom.hpp"
+#include "ConfigVector.hpp"
+#include "ConfigView.hpp"
+#include "ConfigSchema.hpp"
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace configmaps;
+
+static std::vector<std::string> makeKeys(size_t n)
+{
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back("key_" + std::to_string(i));
+    return keys;
+}
+
+TEST_CASE("FIFOMap lookup", "[benchmark][FIFOMap]")
+{
+    for (size_t n : {100, 1000, 10000})
+    {
+        std::vector<std::string> keys = makeKeys(n);
+        FIFOMap<std::string, int> map;
+        for (size_t i = 0; i < n; ++i)
+            map[keys[i]] = (int)i;
+
+        BENCHMARK("find " + std::to_string(n) + " keys")
+        {
+            size_t hits = 0;
+            for (const std::string &key : keys)
+                hits += map.find(key) != map.end();
+            return hits;
+        };
+
+        BENCHMARK("fill and erase " + std::to_string(n) + " keys")
+        {
+            FIFOMap<std::string, int> m;
+            for (const std::string &key : keys)
+                m[key] = 1;
+            for (const std::string &key : keys)
+                m.erase(key);
+            return m.size();
+        };
+    }
+}
+
+TEST_CASE("ConfigMap hasKey", "[benchmark][ConfigMap]")
+{
+    const size_t n = 5000;
+    std::vector<std::string> keys = makeKeys(n);
+    ConfigMap map;
+    for (size_t i = 0; i < n; ++i)
+        map[keys[i]] = (int)i;
+
+    BENCHMARK("hasKey 5000 keys")
+    {
+        size_t hits = 0;
+        for (const std::string &key : keys)
+            hits += map.hasKey(key);
+        return hits;
+    };
+}
+
+TEST_CASE("ConfigAtom parse", "[benchmark][ConfigAtom]")
+{
+    const size_t n = 10000;
+    std::vector<std::string> ints, doubles;
+    for (size_t i = 0; i < n; ++i)
+    {
+        ints.push_back(std::to_string(i * 7919));
+        doubles.push_back(std::to_string(i * 0.37) + "e-3");
+    }
+
+    BENCHMARK("parse 10000 ints")
+    {
+        long sum = 0;
+        for (const std::string &s : ints)
+            sum += ConfigAtom(s).getInt();
+        return sum;
+    };
+
+    BENCHMARK("parse 10000 doubles")
+    {
+        double sum = 0;
+        for (const std::string &s : doubles)
+            sum += ConfigAtom(s).getDouble();
+        return sum;
+    };
+
+    BENCHMARK("parse 10000 bools")
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i)
+            count += ConfigAtom(i % 2 ? "true" : "False").getBool();
+        return count;
+    };
+}
+
+TEST_CASE("ConfigAtom format", "[benchmark][ConfigAtom]")
+{
+    ConfigItem list;
+    for (size_t i = 0; i < 10000; ++i)
+        list.push_back(i * 0.37);
+
+    BENCHMARK("dump 10000 doubles to YAML")
+    {
+        return list.toYamlString().size();
+    };
+}
+
+TEST_CASE("ConfigMap load", "[benchmark][ConfigMap]")
+{
+    std::string text;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        std::string n = std::to_string(i);
+        text += "link" + n + ":\n  name: link" + n + "\n  mass: " + n +
+            ".5\n  inertia: [1, 0, 0, 0, 1, 0, 0, 0, 1]\n";
+    }
+
+    BENCHMARK("load YAML with 2000 links")
+    {
+        return ConfigMap::fromYamlString(text).size();
+    };
+
+    BENCHMARK("load YAML::Node with 2000 links")
+    {
+        return ConfigItem(YAML::Load(text)).size();
+    };
+
+    YAML::Node node = YAML::Load(text);
+
+    BENCHMARK("convert YAML::Node with 2000 links")
+    {
+        return ConfigItem(node).size();
+    };
+
+    BENCHMARK("convert YAML::Node lazily and read one value of 2000 links")
+    {
+        return (double)ConfigItem::fromYamlNodeLazy(node)["link1999"]["mass"];
+    };
+
+    std::string json = ConfigMap::fromYamlString(text).toJsonString();
+
+    BENCHMARK("load JSON with 2000 links")
+    {
+        return ConfigMap::fromJsonString(json).size();
+    };
+
+    BENCHMARK("load Json::Value with 2000 links")
+    {
+        Json::Value v;
+        std::istringstream in(json);
+        in >> v;
+        return ConfigItem(v).size();
+    };
+
+    ConfigMap map = ConfigMap::fromYamlString(text);
+    ConfigItem item = ConfigItem::fromYamlString(text);
+
+    BENCHMARK("copy ConfigItem with 2000 links and change one value")
+    {
+        ConfigItem copy = item;
+        copy["link1999"]["mass"] = 1.0;
+        return copy.size();
+    };
+
+    BENCHMARK("copy ConfigMap with 2000 links")
+    {
+        ConfigMap copy = map;
+        return copy.size();
+    };
+
+    BENCHMARK("write JSON with 2000 links")
+    {
+        return map.toJsonString().size();
+    };
+
+    BENCHMARK("write Json::Value with 2000 links")
+    {
+        Json::Value root;
+        map.dumpToJsonValue(root);
+        return root.toStyledString().size();
+    };
+
+    std::string binary = map.toBinary();
+
+    BENCHMARK("write binary with 2000 links")
+    {
+        return map.toBinary().size();
+    };
+
+    BENCHMARK("load binary with 2000 links")
+    {
+        return ConfigMap::fromBinary(binary).size();
+    };
+
+    BENCHMARK("view binary and read one value of 2000 links")
+    {
+        return (double)ConfigView::fromBinary(binary)["link1999"]["mass"];
+    };
+
+    {
+        std::ofstream f("bench_links.yml");
+        f << text;
+    }
+    ConfigItem::enableYamlCache();
+
+    BENCHMARK("load cached YAML file with 2000 links")
+    {
+        return ConfigMap::fromYamlFile("bench_links.yml").size();
+    };
+
+    ConfigItem::disableYamlCache();
+    ConfigItem::enableParsedFileCache();
+
+    BENCHMARK("load YAML file with 2000 links from the parsed file cache")
+    {
+        return ConfigMap::fromYamlFile("bench_links.yml").size();
+    };
+
+    ConfigItem::disableParsedFileCache();
+    std::remove("bench_links.yml");
+    std::remove("bench_links.yml.cmb");
+}
+
+TEST_CASE("ConfigSchema validate", "[benchmark][ConfigSchema]")
+{
+    ConfigMap schema = ConfigMap::fromYamlString(
+        "name: {type: string, required: true}\n"
+        "links:\n"
+        "  type: array\n"
+        "  required: true\n"
+        "  contains:\n"
+        "    type: object\n"
+        "    properties:\n"
+        "      name: {type: string, required: true}\n"
+        "      mass: {type: number, minimum: 0, maximum: 1000}\n"
+        "      fixed: {type: boolean}\n");
+    ConfigMap config;
+    config["name"] = "robot";
+    for (size_t i = 0; i < 500; ++i)
+    {
+        ConfigItem &link = config["links"][i];
+        link["name"] = "link" + std::to_string(i);
+        link["mass"] = i + 0.5;
+        link["fixed"] = false;
+    }
+    ConfigSchema cs(schema);
+
+    BENCHMARK("validate 500 links")
+    {
+        return cs.validate(config);
+    };
+
+    BENCHMARK("construct schema and validate 500 links")
+    {
+        return ConfigSchema(schema).validate(config);
+    };
+}
@@ -3,9 +3,71 @@
 #include "ConfigAtom.hpp"
 #include "ConfigVector.hpp"
 #include "ConfigSchema.hpp"
+#include "ConfigView.hpp"
 #include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <limits>
 using namespace configmaps;
 
+// Allocation tracking for the tests below. Every allocation gets a small
+// header that stores its size so that live and peak bytes can be tracked.
+namespace
+{
+    const size_t ALLOC_HEADER = 16;
+    // atomic since includes are loaded on several threads
+    std::atomic<size_t> allocationCount(0);
+    std::atomic<size_t> liveBytes(0);
+    std::atomic<size_t> peakBytes(0);
+
+    void resetAllocationStats()
+    {
+        allocationCount = 0;
+        peakBytes = liveBytes.load();
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    char *p = static_cast<char *>(std::malloc(size + ALLOC_HEADER));
+    if (!p)
+        throw std::bad_alloc();
+    *reinterpret_cast<std::size_t *>(p) = size;
+    ++allocationCount;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+        peakBytes = liveBytes.load();
+    return p + ALLOC_HEADER;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    char *p = static_cast<char *>(ptr) - ALLOC_HEADER;
+    liveBytes -= *reinterpret_cast<std::size_t *>(p);
+    std::free(p);
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return operator new(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return operator new(size); } catch (...) { return nullptr; }
+}
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { operator delete(ptr); }
+
 TEST_CASE("ConfigMap", "boolean")
 {
 
@@ -293,3 +355,1090 @@ TEST_CASE("min_max_tests", "checks valid and invalid values for integers and num
     }
 }
 
+
+TEST_CASE("FIFOMap", "keeps insertion order through lookup, erase and copy")
+{
+    FIFOMap<std::string, int> map;
+    for (int i = 0; i < 100; ++i)
+        map["key" + std::to_string(99 - i)] = i;
+    REQUIRE(map.size() == 100);
+    REQUIRE(map.find("key42") != map.end());
+    REQUIRE(map.find("key42")->second == 57);
+    REQUIRE(map.find("missing") == map.end());
+
+    int &ref = map["key0"];
+    for (int i = 100; i < 1000; ++i)
+        map["key" + std::to_string(i)] = i;
+    ref = -1;
+    REQUIRE(map["key0"] == -1);
+
+    for (int i = 0; i < 1000; i += 2)
+        REQUIRE(map.erase("key" + std::to_string(i)) == 1);
+    REQUIRE(map.erase("key0") == 0);
+    REQUIRE(map.size() == 500);
+
+    map["key0"] = 7;
+    int expected = 99;
+    FIFOMap<std::string, int>::iterator it = map.begin();
+    for (; expected > 0; expected -= 2, ++it)
+        REQUIRE(it->first == "key" + std::to_string(expected));
+    REQUIRE(it->first == "key101");
+    REQUIRE((--map.end())->first == "key0");
+
+    FIFOMap<std::string, int> copy = map;
+    REQUIRE(copy.size() == map.size());
+    REQUIRE(copy.begin()->first == "key99");
+    copy.erase(copy.begin(), copy.end());
+    REQUIRE(copy.empty());
+    REQUIRE(copy.begin() == copy.end());
+
+    REQUIRE(map.rbegin()->first == "key0");
+    REQUIRE((++map.rbegin())->first == "key999");
+    REQUIRE(map.count("key1") == 1);
+}
+
+TEST_CASE("FIFOMap_erase", "erases keys while iterating the map")
+{
+    FIFOMap<std::string, int> map;
+    for (int i = 0; i < 10; ++i)
+        map["key" + std::to_string(i)] = i;
+    int &kept = map["key9"];
+
+    // erasing most keys keeps the positions of the others
+    FIFOMap<std::string, int>::iterator it = map.begin();
+    while (it != map.end())
+    {
+        if (it->second != 3 && it->second != 9)
+            map.erase(it++);
+        else
+            ++it;
+    }
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.begin()->first == "key3");
+    REQUIRE((--map.end())->first == "key9");
+    kept = 90;
+    REQUIRE(map["key9"] == 90);
+
+    // erasing the last key drops its storage behind the iterator
+    it = map.find("key9");
+    map.erase(it++);
+    REQUIRE(it == map.end());
+    REQUIRE((--map.end())->first == "key3");
+    for (it = map.begin(); it != map.end();)
+        map.erase(it++);
+    REQUIRE(map.empty());
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(map.rbegin() == map.rend());
+
+    map["again"] = 1;
+    REQUIRE(map.begin()->first == "again");
+    REQUIRE(map.size() == 1);
+
+    // a sliding window of keys does not keep the dead entries
+    size_t before = liveBytes;
+    FIFOMap<std::string, int> window;
+    size_t erased = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        window["key" + std::to_string(i)] = i;
+        if (i >= 5)
+            erased += window.erase("key" + std::to_string(i - 5));
+    }
+    REQUIRE(erased == 99995);
+    REQUIRE(liveBytes - before < 4096);
+    REQUIRE(window.size() == 5);
+    REQUIRE(window.begin()->first == "key99995");
+    REQUIRE(window.rbegin()->first == "key99999");
+    REQUIRE(window.count("key99994") == 0);
+    REQUIRE(window.at("key99997") == 99997);
+
+    // the items of a compacted ConfigMap keep their parent
+    ConfigMap config;
+    for (int i = 0; i < 100; ++i)
+    {
+        config["key" + std::to_string(i)]["value"] = i;
+        if (i >= 5)
+            config.erase("key" + std::to_string(i - 5));
+    }
+    REQUIRE(config.size() == 5);
+    REQUIRE(config["key97"]["value"].getPath() == "/key97/value");
+}
+
+TEST_CASE("string_view_lookup", "looks up keys by std::string_view and literals")
+{
+    ConfigMap map;
+    map["name"] = "robot";
+    map["joints"]["hip"] = 1.5;
+    std::string_view key = "joints";
+    REQUIRE(map.hasKey(key));
+    REQUIRE(map.hasKey("name"));
+    REQUIRE(!map.hasKey(std::string_view("jointsX").substr(0, 5)));
+    REQUIRE(map[key].hasKey(std::string_view("hip")));
+    REQUIRE((double)map[key][std::string_view("hip")] == 1.5);
+    REQUIRE(map.find(std::string_view("name")) == map.begin());
+    REQUIRE(map.get(std::string_view("missing"), 3) == 3);
+    REQUIRE(map.size() == 2);
+}
+
+TEST_CASE("move_semantics", "moves subtrees between maps without copying them")
+{
+    ConfigMap source;
+    source["robot"]["name"] = "crex";
+    source["robot"]["legs"].push_back(1);
+    source["robot"]["legs"].push_back(2);
+    ConfigMap *robot = source["robot"];
+
+    ConfigMap target;
+    target["robot"] = std::move(source["robot"]);
+    source.erase("robot");
+    REQUIRE((ConfigMap *)target["robot"] == robot);
+    REQUIRE((std::string)target["robot"]["name"] == "crex");
+    REQUIRE(target["robot"]["legs"].size() == 2);
+    REQUIRE(source.empty());
+
+    // assigning a child to its parent must not free the child first
+    target["robot"] = target["robot"]["name"];
+    REQUIRE((std::string)target["robot"] == "crex");
+
+    ConfigMap update;
+    update["robot"]["name"] = "charlie";
+    update["robot"]["id"] = 3;
+    ConfigMap base;
+    base["robot"]["name"] = "crex";
+    base["robot"]["legs"] = 6;
+    base.updateMap(std::move(update));
+    REQUIRE((std::string)base["robot"]["name"] == "charlie");
+    REQUIRE((int)base["robot"]["legs"] == 6);
+    REQUIRE((int)base["robot"]["id"] == 3);
+
+    ConfigItem atom;
+    atom = 5;
+    atom.push_back(6);
+    REQUIRE(atom.size() == 2);
+    REQUIRE((int)atom[0] == 5);
+
+    ConfigMap moved = std::move(base);
+    REQUIRE(moved.size() == 1);
+    REQUIRE(((ConfigMap &)moved["robot"]).size() == 3);
+}
+
+TEST_CASE("root_extraction", "ConfigMap factories take over the parsed tree without copying it")
+{
+    std::ostringstream yaml;
+    for (int i = 0; i < 200; ++i)
+    {
+        yaml << "link" << i << ":\n";
+        yaml << "  name: link" << i << "\n";
+        yaml << "  mass: " << i << ".5\n";
+        yaml << "  size: [1, 2, 3]\n";
+    }
+    std::string text = yaml.str();
+
+    size_t itemAllocations, itemPeak;
+    {
+        resetAllocationStats();
+        size_t before = liveBytes;
+        ConfigItem item = ConfigItem::fromYamlString(text);
+        itemAllocations = allocationCount;
+        itemPeak = peakBytes - before;
+    }
+    size_t mapAllocations, mapPeak;
+    {
+        resetAllocationStats();
+        size_t before = liveBytes;
+        ConfigMap map = ConfigMap::fromYamlString(text);
+        mapAllocations = allocationCount;
+        mapPeak = peakBytes - before;
+        REQUIRE(map.size() == 200);
+        REQUIRE((double)map["link7"]["mass"] == 7.5);
+    }
+    REQUIRE(mapAllocations <= itemAllocations + 2);
+    REQUIRE(mapPeak <= itemPeak + 1024);
+}
+
+TEST_CASE("node_type", "dispatches on the node type tag of the items")
+{
+    ConfigMap map;
+    map["atom"] = 1;
+    map["list"].push_back(1);
+    map["list"].push_back(2);
+    map["sub"]["key"] = "value";
+    REQUIRE(map.getNodeType() == ConfigBase::MAP_NODE);
+    REQUIRE(map["atom"].isAtom());
+    REQUIRE(map["list"].isVector());
+    REQUIRE(map["sub"].isMap());
+    REQUIRE(!map["sub"].isAtom());
+    REQUIRE(map["list"].size() == 2);
+    REQUIRE(map["sub"].size() == 1);
+    REQUIRE(map["atom"].size() == 1);
+
+    ConfigItem copy = map;
+    REQUIRE(copy.isMap());
+    REQUIRE(((ConfigBase &)copy["list"]).getNodeType() == ConfigBase::VECTOR_NODE);
+    REQUIRE(((ConfigBase &)copy["atom"]).getNodeType() == ConfigBase::ATOM_NODE);
+    REQUIRE_THROWS(copy["atom"]["key"]);
+}
+
+TEST_CASE("inline_atoms", "stores atoms inside the items without heap allocations")
+{
+    ConfigItem list;
+    list.push_back(0);
+    ConfigVector &vector = list;
+    vector.reserve(1000);
+    resetAllocationStats();
+    for (int i = 1; i < 1000; ++i)
+        list.push_back(i);
+    REQUIRE(allocationCount == 0);
+    REQUIRE(list.size() == 1000);
+    REQUIRE((int)list[999] == 999);
+
+    // atoms survive the reallocation of their vector
+    list.push_back(1000);
+    REQUIRE((int)list[500] == 500);
+
+    ConfigItem atom;
+    atom = 2.5;
+    ConfigItem moved = std::move(atom);
+    REQUIRE(moved.isAtom());
+    REQUIRE(!atom.isAtom());
+    REQUIRE((double)moved == 2.5);
+    moved.swap(list);
+    REQUIRE(moved.size() == 1001);
+    REQUIRE((double)list == 2.5);
+
+    ConfigMap map;
+    map["value"] = 3;
+    map["value"] = map["value"];
+    REQUIRE((int)map["value"] == 3);
+}
+
+TEST_CASE("compact_atom", "keeps one value per atom and parses it on demand")
+{
+    REQUIRE(sizeof(ConfigAtom) <= ConfigItem::ATOM_STORAGE_SIZE);
+
+    ConfigAtom atom(std::string("42"));
+    REQUIRE(atom.getType() == ConfigAtom::UNDEFINED_TYPE);
+    REQUIRE(atom.testType(ConfigAtom::DOUBLE_TYPE));
+    REQUIRE(atom.testType(ConfigAtom::INT_TYPE));
+    REQUIRE(atom.getType() == ConfigAtom::UNDEFINED_TYPE);
+    REQUIRE(atom.getInt() == 42);
+    REQUIRE(atom.getType() == ConfigAtom::INT_TYPE);
+    REQUIRE(atom.getUnparsedString() == "42");
+    REQUIRE_THROWS(atom.getDouble());
+
+    ConfigAtom flag(std::string(" True "));
+    REQUIRE(flag.getBool());
+    REQUIRE(flag.toString() == "true");
+
+    ConfigAtom text("a long string that does not fit into a small buffer");
+    REQUIRE(!text.testType(ConfigAtom::INT_TYPE));
+    REQUIRE(text.getString() == "a long string that does not fit into a small buffer");
+    text.setDouble(1.5);
+    REQUIRE(text.getDouble() == 1.5);
+    REQUIRE(text.toString() == "1.5");
+}
+
+TEST_CASE("key_path", "builds the key path of a node from its parent links")
+{
+    ConfigMap map;
+    map["robot"]["links"][0]["name"] = "base";
+    map["robot"]["links"][1]["mass"] = 2;
+    REQUIRE(map["robot"]["links"][1]["mass"].getPath() == "/robot/links/1/mass");
+    REQUIRE(((ConfigBase &)map["robot"]["links"]).getParentName() == "links");
+    REQUIRE(map.getPath() == "/");
+
+    ConfigMap copy = map;
+    REQUIRE(copy["robot"]["links"][0]["name"].getPath() == "/robot/links/0/name");
+    ConfigItem empty;
+    copy["robot"]["joints"] = empty;
+    REQUIRE(copy["robot"]["joints"].getPath() == "/robot/joints");
+
+    ConfigMap loaded = ConfigMap::fromYamlString("robot:\n  links:\n    - {name: base, mass: 2}\n");
+    try
+    {
+        (int)loaded["robot"]["links"][0]["mass"];
+        (double)loaded["robot"]["links"][0]["mass"];
+        FAIL("reading an int as double should throw");
+    }
+    catch (const std::runtime_error &e)
+    {
+        REQUIRE(std::string(e.what()).find("/robot/links/0/mass") != std::string::npos);
+    }
+
+    // an item moved out of its map does not point to the map anymore
+    ConfigMap *owner = new ConfigMap();
+    (*owner)["a"]["b"] = 1;
+    ConfigItem moved(std::move((*owner)["a"]));
+    delete owner;
+    REQUIRE(moved.getPath() == "/");
+    REQUIRE(moved["b"].getPath() == "/b");
+    REQUIRE_THROWS_AS(moved["b"]["c"], ConfigItem::WrongTypeException);
+
+    // items keep their paths when the vector relocates them
+    ConfigVector vector;
+    for (int i = 0; i < 20; ++i)
+        vector[vector.append(ConfigItem())]["x"] = i;
+    vector.push_back(ConfigItem());
+    vector.emplace_back();
+    vector.insert(vector.begin(), ConfigItem());
+    vector[0]["y"] = 1;
+    REQUIRE(vector[0]["y"].getPath() == "/0/y");
+    REQUIRE(vector[20]["x"].getPath() == "/20/x");
+    REQUIRE(vector[21].getPath() == "/21");
+    REQUIRE(vector[22].getPath() == "/22");
+}
+
+TEST_CASE("item_size", "keeps ConfigItem at two pointers plus the inline atom")
+{
+    // the node, the parent and the inline atom on 64 bit, 128 bytes with
+    // the former exception members and c_str buffer
+    REQUIRE(sizeof(ConfigItem) <= 80);
+
+    ConfigItem item;
+    item = "name";
+    const char *text = item.c_str();
+    REQUIRE(std::string(text) == "name");
+    REQUIRE(item.c_str() == text);
+
+    ConfigItem number;
+    number = 3;
+    REQUIRE_THROWS_AS(number["key"], ConfigItem::WrongTypeException);
+    REQUIRE_THROWS_AS(number[-1], ConfigItem::BadIndexException);
+    REQUIRE_THROWS_AS(ConfigItem().size(), ConfigItem::NoTypeException);
+}
+
+TEST_CASE("strict_parsing", "parses numbers and booleans only if the whole text matches")
+{
+    REQUIRE(ConfigAtom(" 42 ").testType(ConfigAtom::INT_TYPE));
+    REQUIRE(ConfigAtom("+42").getInt() == 42);
+    REQUIRE(ConfigAtom("-42").getInt() == -42);
+    REQUIRE(!ConfigAtom("42abc").testType(ConfigAtom::INT_TYPE));
+    REQUIRE(!ConfigAtom("4.2").testType(ConfigAtom::INT_TYPE));
+    REQUIRE(!ConfigAtom("+-4").testType(ConfigAtom::INT_TYPE));
+    REQUIRE(!ConfigAtom("-1").testType(ConfigAtom::UINT_TYPE));
+    REQUIRE(!ConfigAtom("99999999999").testType(ConfigAtom::INT_TYPE));
+    REQUIRE(ConfigAtom("99999999999").getULong() == 99999999999ul);
+    REQUIRE(ConfigAtom("1e-9").getDouble() == 1e-9);
+    REQUIRE(ConfigAtom("0.1").getDouble() == 0.1);
+    REQUIRE(!ConfigAtom("0,1").testType(ConfigAtom::DOUBLE_TYPE));
+    REQUIRE(ConfigAtom("4.9e-324").testType(ConfigAtom::DOUBLE_TYPE));
+    REQUIRE(ConfigAtom("4.9e-324").getDouble() == std::numeric_limits<double>::denorm_min());
+    REQUIRE(ConfigAtom("-1e-310").getDouble() == -1e-310);
+    REQUIRE(ConfigAtom("1e-400").getDouble() == 0.0);
+    REQUIRE(ConfigAtom("1e400").getDouble() == std::numeric_limits<double>::infinity());
+    REQUIRE(ConfigAtom("-1e400").getDouble() == -std::numeric_limits<double>::infinity());
+    REQUIRE(!ConfigAtom("1e400x").testType(ConfigAtom::DOUBLE_TYPE));
+    REQUIRE(!ConfigAtom("").testType(ConfigAtom::DOUBLE_TYPE));
+
+    REQUIRE(ConfigAtom("TRUE").getBool());
+    REQUIRE(!ConfigAtom("False").getBool());
+    REQUIRE(ConfigAtom("1").getBool());
+    REQUIRE(!ConfigAtom("fals").testType(ConfigAtom::BOOL_TYPE));
+    REQUIRE(!ConfigAtom("tRUE").testType(ConfigAtom::BOOL_TYPE));
+}
+
+TEST_CASE("number_round_trip", "writes numbers that reload bit-identically")
+{
+    const double values[] = {1e-9, 0.1, 1.0 / 3.0, -2.5e300, 4.9e-324, 123456789.125, 2.0,
+                             -0.0, 1e21};
+    ConfigMap map;
+    for (double v : values)
+        map["doubles"].push_back(v);
+    map["int"] = -2147483647;
+    map["uint"] = 4294967295u;
+    map["ulong"] = 18446744073709551615ul;
+    map["flag"] = true;
+
+    REQUIRE(ConfigAtom(1e-9).toString() == "1e-09");
+    REQUIRE(ConfigAtom(2.0).toString() == "2.0");
+    REQUIRE(ConfigAtom(-0.0).toString() == "-0.0");
+
+    ConfigMap yaml = ConfigMap::fromYamlString(map.toYamlString());
+    ConfigMap json = ConfigMap::fromJsonString(map.toJsonString());
+    for (ConfigMap *loaded : {&yaml, &json})
+    {
+        ConfigMap &m = *loaded;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+        {
+            REQUIRE((double)m["doubles"][i] == values[i]);
+            REQUIRE(std::signbit((double)m["doubles"][i]) == std::signbit(values[i]));
+        }
+        REQUIRE((int)m["int"] == -2147483647);
+        REQUIRE((unsigned int)m["uint"] == 4294967295u);
+        REQUIRE((unsigned long)m["ulong"] == 18446744073709551615ul);
+        REQUIRE((bool)m["flag"]);
+    }
+}
+
+TEST_CASE("yaml_events", "builds the items directly from the YAML parser events")
+{
+    std::string text =
+        "name: robot\n"
+        "empty:\n"
+        "quoted: \"null\"\n"
+        "base: &base {mass: 1.5, size: [1, 2, 3]}\n"
+        "copy: *base\n"
+        "links:\n"
+        "  - name: &link_name first\n"
+        "    inertia: [[1, 0], [0, 1]]\n"
+        "  - name: *link_name\n"
+        "    flags: {}\n"
+        "name: duplicate\n";
+    ConfigMap map = ConfigMap::fromYamlString(text);
+    ConfigItem reference(YAML::Load(text));
+    REQUIRE(map.toYamlString() == reference.toYamlString());
+
+    REQUIRE((std::string)map["name"] == "robot");
+    REQUIRE(!map.hasKey("empty"));
+    REQUIRE((std::string)map["quoted"] == "null");
+    REQUIRE((double)map["copy"]["mass"] == 1.5);
+    REQUIRE(map["copy"]["size"].size() == 3);
+    REQUIRE((std::string)map["links"][1]["name"] == "first");
+    REQUIRE((int)map["links"][0]["inertia"][1][1] == 1);
+    REQUIRE(map["links"][1]["flags"].isMap());
+    REQUIRE(map["links"][0]["inertia"][1][0].getPath() == "/links/0/inertia/1/0");
+
+    // anchored subtrees keep the links to their parents, also when they
+    // are only read
+    ConfigMap anchored = ConfigMap::fromYamlString(
+        "robot:\n  base: &base {link: {mass: 1.5}}\n  copy: *base\n"
+        "single: &single {link: {mass: 2}}\n");
+    auto child = [](const ConfigBase *node, const char *key) {
+        return static_cast<const ConfigMap *>(node)->at(key).getNode();
+    };
+    REQUIRE(child(child(&anchored, "single"), "link")->getPath() == "/single/link");
+    REQUIRE(child(child(child(&anchored, "robot"), "base"), "link")->getPath() == "/robot/base/link");
+    REQUIRE(anchored["robot"]["copy"]["link"]["mass"].getPath() == "/robot/copy/link/mass");
+
+    REQUIRE((int)ConfigItem::fromYamlString("42") == 42);
+    REQUIRE_THROWS(ConfigItem::fromYamlString(""));
+    REQUIRE_THROWS(ConfigItem::fromYamlString("[1, ~]"));
+    REQUIRE_THROWS(ConfigItem::fromYamlString("{a: [1, 2}"));
+}
+
+TEST_CASE("json_reader", "reads JSON straight into typed atoms")
+{
+    std::string text =
+        "{\n"
+        "  // comments are accepted like before\n"
+        "  \"name\": \"robot \\\"one\\\"\\n\\u00e4\\ud83d\\ude00\",\n"
+        "  \"count\": 42, \"big\": 4294967296, \"mass\": -1.5e2,\n"
+        "  \"enabled\": true, \"missing\": null, \"number\": \"7\",\n"
+        "  \"links\": [{\"name\": \"a\"}, [], null],\n"
+        "  \"count\": 43 /* the last duplicate wins */\n"
+        "}";
+    ConfigMap map = ConfigMap::fromJsonString(text);
+    REQUIRE(map.size() == 7);
+    REQUIRE((std::string)map["name"] == "robot \"one\"\n\xc3\xa4\xf0\x9f\x98\x80");
+    REQUIRE(map["count"].getOrCreateAtom()->getType() == ConfigAtom::INT_TYPE);
+    REQUIRE((int)map["count"] == 43);
+    REQUIRE(map["big"].getOrCreateAtom()->getType() == ConfigAtom::ULONG_TYPE);
+    REQUIRE((unsigned long)map["big"] == 4294967296ul);
+    REQUIRE(map["mass"].getOrCreateAtom()->getType() == ConfigAtom::DOUBLE_TYPE);
+    REQUIRE((double)map["mass"] == -150.0);
+    REQUIRE((bool)map["enabled"]);
+    REQUIRE(!map.hasKey("missing"));
+    REQUIRE(map["number"].getOrCreateAtom()->getType() == ConfigAtom::UNDEFINED_TYPE);
+    REQUIRE((std::string)map["links"][0]["name"] == "a");
+    REQUIRE(map["links"][1].isVector());
+    REQUIRE((std::string)map["links"][2] == "");
+    REQUIRE(map["links"][0]["name"].getPath() == "/links/0/name");
+
+    // inferred atoms convert on the first get like unparsed text
+    ConfigItem atom = ConfigItem::fromJsonString("5");
+    REQUIRE(atom.getOrCreateAtom()->testType(ConfigAtom::DOUBLE_TYPE));
+    REQUIRE((double)atom == 5.0);
+    REQUIRE(!atom.getOrCreateAtom()->isInferred());
+    REQUIRE_THROWS((int)atom);
+    REQUIRE((std::string)ConfigItem::fromJsonString("2.5") == "2.5");
+    REQUIRE((int)ConfigItem::fromJsonString("2.5") == 0);
+
+    // integers beyond int and unsigned long keep their text, -0 its sign
+    ConfigMap wide = ConfigMap::fromJsonString(
+        "{\"n\": -9007199254740993, \"huge\": 18446744073709551616, \"zero\": -0}");
+    REQUIRE(wide["n"].getOrCreateAtom()->getType() == ConfigAtom::UNDEFINED_TYPE);
+    REQUIRE((std::string)wide["n"] == "-9007199254740993");
+    REQUIRE((std::string)wide["huge"] == "18446744073709551616");
+    REQUIRE(wide["zero"].getOrCreateAtom()->getType() == ConfigAtom::DOUBLE_TYPE);
+    REQUIRE(std::signbit((double)wide["zero"]));
+    REQUIRE(ConfigMap::fromJsonString(wide.toJsonString()).toJsonString() == wide.toJsonString());
+    REQUIRE(wide.toJsonString().find("-9007199254740993") != std::string::npos);
+
+    // values beyond the normal range read like strtod reads them
+    REQUIRE((double)ConfigItem::fromJsonString("5e-324") == std::numeric_limits<double>::denorm_min());
+    REQUIRE((double)ConfigItem::fromJsonString("-1e-310") == -1e-310);
+    REQUIRE((double)ConfigItem::fromJsonString("1e-400") == 0.0);
+    REQUIRE((double)ConfigItem::fromJsonString("1e400") == std::numeric_limits<double>::infinity());
+
+    REQUIRE_THROWS(ConfigItem::fromJsonString(""));
+    REQUIRE_THROWS(ConfigItem::fromJsonString("{\"a\": 1,}"));
+    REQUIRE_THROWS(ConfigItem::fromJsonString("[1 2]"));
+    REQUIRE_THROWS(ConfigItem::fromJsonString("\"\\ud800\""));
+    REQUIRE_THROWS(ConfigItem::fromJsonString("01"));
+    REQUIRE_THROWS(ConfigItem::fromJsonString("{} {}"));
+}
+
+TEST_CASE("json_writer", "writes JSON straight to the output")
+{
+    ConfigMap map;
+    map["name"] = "robot \"one\"\n\x01";
+    map["enabled"] = true;
+    map["size"].push_back(1);
+    map["size"].push_back(2.5);
+    map["empty"] = ConfigMap();
+    map["links"].append(ConfigMap());
+    map["links"][0]["name"] = "a";
+
+    REQUIRE(map.toJsonString(false) ==
+            "{\"name\":\"robot \\\"one\\\"\\n\\u0001\",\"enabled\":true,"
+            "\"size\":[1,2.5],\"empty\":{},\"links\":[{\"name\":\"a\"}]}");
+    REQUIRE(map.toJsonString() ==
+            "{\n"
+            "   \"name\" : \"robot \\\"one\\\"\\n\\u0001\",\n"
+            "   \"enabled\" : true,\n"
+            "   \"size\" : [ 1, 2.5 ],\n"
+            "   \"empty\" : {},\n"
+            "   \"links\" : [\n"
+            "      {\n"
+            "         \"name\" : \"a\"\n"
+            "      }\n"
+            "   ]\n"
+            "}\n");
+
+    // larger than the buffer of the writer
+    ConfigItem list;
+    for (int i = 0; i < 2000; ++i)
+        list.push_back(ConfigItem(std::string(i % 50, 'x')));
+    std::ostringstream out;
+    list.toJsonStream(out, false);
+    REQUIRE(out.str() == list.toJsonString(false));
+    ConfigItem recovered = ConfigItem::fromJsonString(out.str());
+    REQUIRE(recovered.size() == 2000);
+    REQUIRE((std::string)recovered[1999] == std::string(1999 % 50, 'x'));
+    REQUIRE_THROWS(ConfigItem().toJsonString());
+}
+
+namespace
+{
+    // Counts the written characters without keeping them.
+    class CountingBuffer : public std::streambuf
+    {
+    public:
+        size_t count = 0;
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            ++count;
+            return c;
+        }
+        std::streamsize xsputn(const char *, std::streamsize n) override
+        {
+            count += n;
+            return n;
+        }
+    };
+}
+
+TEST_CASE("yaml_streaming", "writes YAML to the stream while walking the tree")
+{
+    ConfigMap map;
+    for (int i = 0; i < 2000; ++i)
+    {
+        ConfigMap &link = map["link" + std::to_string(i)];
+        link["name"] = "link" + std::to_string(i);
+        link["mass"] = i + 0.5;
+        link["description"] = std::string(64, 'x');
+    }
+    std::string text = map.toYamlString();
+    REQUIRE(ConfigMap::fromYamlString(text).toYamlString() == text);
+
+    CountingBuffer buffer;
+    std::ostream out(&buffer);
+    resetAllocationStats();
+    size_t before = liveBytes;
+    map.toYamlStream(out);
+    REQUIRE(buffer.count == text.size());
+    // the whole text is never held in memory
+    REQUIRE(peakBytes - before < text.size() / 16);
+}
+
+TEST_CASE("json_types", "writes numbers and bools as JSON values")
+{
+    ConfigMap map = ConfigMap::fromYamlString(
+        "int: 42\n"
+        "negative: -1.5e3\n"
+        "big: 18446744073709551615\n"
+        "yes: True\n"
+        "plus: +5\n"
+        "octal: 017\n"
+        "name: robot\n");
+    map["typed"] = 2.5;
+    map["flag"] = false;
+    map["text"].getOrCreateAtom()->setString("7");
+    map["nan"] = std::nan("");
+    REQUIRE(map.toJsonString(false) ==
+            "{\"int\":42,\"negative\":-1.5e3,\"big\":18446744073709551615,"
+            "\"yes\":true,\"plus\":\"+5\",\"octal\":\"017\",\"name\":\"robot\","
+            "\"typed\":2.5,\"flag\":false,\"text\":\"7\",\"nan\":\"nan\"}");
+
+    Json::Value root;
+    map.dumpToJsonValue(root);
+    REQUIRE(root["int"].isInt());
+    REQUIRE(root["negative"].asDouble() == -1500.0);
+    REQUIRE(root["big"].asUInt64() == 18446744073709551615ul);
+    REQUIRE(root["yes"].isBool());
+    REQUIRE(root["plus"].isString());
+    REQUIRE(root["typed"].isDouble());
+    REQUIRE(root["text"].isString());
+
+    ConfigMap recovered = ConfigMap::fromJsonString(map.toJsonString());
+    REQUIRE((int)recovered["int"] == 42);
+    REQUIRE((double)recovered["negative"] == -1500.0);
+    REQUIRE((bool)recovered["yes"]);
+    REQUIRE((std::string)recovered["octal"] == "017");
+
+    // text that was a string in its source stays a string
+    std::string json = "{\"version\":\"1.10\",\"id\":\"42\",\"on\":\"true\",\"n\":42}";
+    REQUIRE(ConfigMap::fromJsonString(json).toJsonString(false) == json);
+    ConfigMap quoted = ConfigMap::fromYamlString("a: \"42\"\nb: '1.5'\nc: 42\n");
+    quoted["d"] = std::string("5");
+    quoted["e"] = "true";
+    REQUIRE(quoted.toJsonString(false) ==
+            "{\"a\":\"42\",\"b\":\"1.5\",\"c\":42,\"d\":\"5\",\"e\":\"true\"}");
+    REQUIRE(ConfigMap::fromBinary(quoted.toBinary()).toJsonString(false) ==
+            quoted.toJsonString(false));
+    REQUIRE((int)quoted["a"] == 42);
+    REQUIRE((int)quoted["d"] == 5);
+}
+
+TEST_CASE("binary_format", "round-trips all atom types through the binary encoding")
+{
+    ConfigMap map = ConfigMap::fromYamlString(
+        "name: robot\n"
+        "links:\n"
+        "  - {name: a, mass: 1.5}\n"
+        "  - {name: b, mass: 2.5}\n");
+    map["int"] = -7;
+    map["uint"] = 7u;
+    map["ulong"] = 18446744073709551615ul;
+    map["double"] = 0.1;
+    map["bool"] = true;
+    map["text"].getOrCreateAtom()->setString("42");
+    map["json"] = ConfigItem::fromJsonString("{\"count\": 3}");
+
+    std::string data = map.toBinary();
+    ConfigMap recovered = ConfigMap::fromBinary(data);
+    REQUIRE(recovered.toBinary() == data);
+    REQUIRE(recovered.toYamlString() == map.toYamlString());
+    REQUIRE(recovered["int"].getOrCreateAtom()->getType() == ConfigAtom::INT_TYPE);
+    REQUIRE((int)recovered["int"] == -7);
+    REQUIRE(recovered["uint"].getOrCreateAtom()->getType() == ConfigAtom::UINT_TYPE);
+    REQUIRE((unsigned long)recovered["ulong"] == 18446744073709551615ul);
+    REQUIRE((double)recovered["double"] == 0.1);
+    REQUIRE(recovered["bool"].getOrCreateAtom()->getType() == ConfigAtom::BOOL_TYPE);
+    REQUIRE(recovered["text"].getOrCreateAtom()->getType() == ConfigAtom::STRING_TYPE);
+    REQUIRE(recovered["name"].getOrCreateAtom()->getType() == ConfigAtom::UNDEFINED_TYPE);
+    REQUIRE(recovered["json"]["count"].getOrCreateAtom()->isInferred());
+    REQUIRE(recovered["links"][1]["mass"].getPath() == "/links/1/mass");
+
+    ConfigItem list;
+    list.append(ConfigItem());
+    list.push_back(1);
+    ConfigItem recoveredList = ConfigItem::fromBinary(list.toBinary());
+    REQUIRE(recoveredList.size() == 2);
+    REQUIRE(!recoveredList[0].getNode());
+    REQUIRE((int)recoveredList[1] == 1);
+
+    // keys are stored once
+    REQUIRE(data.find("mass") == data.rfind("mass"));
+
+    for (size_t size = 0; size < data.size(); ++size)
+        REQUIRE_THROWS(ConfigItem::fromBinary(data.data(), size));
+    std::string broken = data;
+    broken[ConfigBinaryWriter::HEADER_SIZE] = 0x7f;
+    REQUIRE_THROWS(ConfigItem::fromBinary(broken));
+    REQUIRE_THROWS(ConfigItem().toBinary());
+}
+
+TEST_CASE("config_view", "navigates a mapped binary snapshot in place")
+{
+    ConfigMap map = ConfigMap::fromYamlString(
+        "name: robot\n"
+        "links:\n"
+        "  - {name: a, mass: 1.5}\n"
+        "  - {name: b, mass: 2.5, size: [1, 2, 3]}\n"
+        "enabled: true\n");
+    map["count"] = 3;
+    map.toBinaryFile("config_view_test.cmb");
+
+    {
+        ConfigView view = ConfigView::open("config_view_test.cmb");
+        REQUIRE(view.isMap());
+        REQUIRE(view.size() == 4);
+        REQUIRE(view.hasKey("links"));
+        REQUIRE(!view.hasKey("mass"));
+        REQUIRE((std::string)view["name"] == "robot");
+        REQUIRE((double)view["links"][1]["mass"] == 2.5);
+        REQUIRE((int)view["links"][1]["size"][2] == 3);
+        REQUIRE(view["count"].getType() == ConfigAtom::INT_TYPE);
+        REQUIRE(view["count"].getInt() == 3);
+        REQUIRE((bool)view["enabled"]);
+        REQUIRE(view.get("missing", 7) == 7);
+        REQUIRE(view.get("count", 7) == 3);
+
+        std::vector<std::string> keys;
+        for (const ConfigView::Entry &entry : view)
+            keys.push_back(std::string(entry.first));
+        REQUIRE(keys == std::vector<std::string>{"name", "links", "enabled", "count"});
+        double mass = 0;
+        for (ConfigView::const_iterator it = view["links"].begin(); it != view["links"].end(); ++it)
+            mass += (double)it->second["mass"];
+        REQUIRE(mass == 4.0);
+
+        // views keep the document alive
+        ConfigView link = ConfigView::open("config_view_test.cmb")["links"][0];
+        REQUIRE((std::string)link["name"] == "a");
+        REQUIRE(view["links"].toItem().toYamlString() == map["links"].toYamlString());
+
+        REQUIRE_THROWS(view["missing"]);
+        REQUIRE_THROWS(view["links"][2]);
+        REQUIRE_THROWS(view["name"]["x"]);
+        REQUIRE_THROWS((int)view["links"]);
+    }
+    std::remove("config_view_test.cmb");
+
+    REQUIRE_THROWS(ConfigView::open("config_view_test.cmb"));
+    REQUIRE_THROWS(ConfigView::fromBinary("not binary"));
+    REQUIRE((int)ConfigView::fromBinary(ConfigItem::fromYamlString("[5]").toBinary())[0] == 5);
+
+    // keys and indices are looked up in the entry tables
+    ConfigItem large;
+    for (int i = 999; i >= 0; --i)
+    {
+        large["key" + std::to_string(i)] = i;
+        large["list"].push_back(i);
+    }
+    ConfigView largeView = ConfigView::fromBinary(large.toBinary());
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE((int)largeView["key" + std::to_string(i)] == i);
+        REQUIRE((int)largeView["list"][(size_t)i] == 999 - i);
+    }
+    REQUIRE(!largeView.hasKey("key1000"));
+    REQUIRE((std::string)largeView.begin()->first == "key999");
+
+    // a map whose only entry ends behind its key
+    std::string truncated("CMB", 3);
+    truncated += (char)ConfigBinaryWriter::VERSION;
+    truncated += std::string("\x1b\0\0\0\0\0\0\0", 8);
+    truncated += (char)ConfigBinaryWriter::MAP_TAG;
+    truncated += std::string("\x0a\0\0\0\x01", 5);
+    truncated += std::string(8, '\0');
+    truncated += std::string("\0\x01\x01" "a", 4);
+    ConfigView truncatedView = ConfigView::fromBinary(truncated);
+    REQUIRE(truncatedView.size() == 1);
+    REQUIRE_THROWS(truncatedView["a"]);
+    REQUIRE_THROWS(truncatedView.begin());
+    REQUIRE_THROWS(ConfigItem::fromBinary(truncated));
+}
+
+static void writeTextFile(const std::string &filename, const std::string &text)
+{
+    std::ofstream f(filename.c_str());
+    f << text;
+}
+
+TEST_CASE("yaml_cache", "reuses the loaded tree while no file changed")
+{
+    std::filesystem::remove_all("yaml_cache_test");
+    std::filesystem::create_directories("yaml_cache_test/cache");
+    writeTextFile("yaml_cache_test/main.yml", "name: robot\nparts:\n  URI: part.yml\n");
+    writeTextFile("yaml_cache_test/part.yml", "mass: 1.5\n");
+    std::string expected = ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true).toYamlString();
+
+    ConfigItem::enableYamlCache();
+    REQUIRE(ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true).toYamlString() == expected);
+    std::string cachePath = "yaml_cache_test/main.yml.uri.cmb";
+    REQUIRE(std::filesystem::exists(cachePath));
+
+    // a tampered cache shows that it is used
+    std::string data;
+    {
+        std::ifstream f(cachePath.c_str(), std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    data.replace(data.rfind("robot"), 5, "cache");
+    writeTextFile(cachePath, data);
+    REQUIRE((std::string)ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true)["name"] == "cache");
+    REQUIRE((std::string)ConfigMap::fromYamlFile("yaml_cache_test/main.yml")["name"] == "robot");
+
+    // changing an included file invalidates the cache
+    writeTextFile("yaml_cache_test/part.yml", "mass: 2.5\n");
+    ConfigMap changed = ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true);
+    REQUIRE((std::string)changed["name"] == "robot");
+    REQUIRE((double)changed["parts"]["mass"] == 2.5);
+
+    ConfigItem::enableYamlCache("yaml_cache_test/cache");
+    ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true);
+    REQUIRE(std::distance(std::filesystem::directory_iterator("yaml_cache_test/cache"),
+                          std::filesystem::directory_iterator()) == 1);
+    REQUIRE((double)ConfigMap::fromYamlFile("yaml_cache_test/main.yml", true)["parts"]["mass"] == 2.5);
+
+    ConfigItem::disableYamlCache();
+    std::filesystem::remove_all("yaml_cache_test");
+}
+
+TEST_CASE("lazy_yaml", "converts subtrees of a YAML document on first access")
+{
+    ConfigMap map;
+    for (int i = 0; i < 2000; ++i)
+    {
+        ConfigMap &link = map["link" + std::to_string(i)];
+        link["name"] = "link" + std::to_string(i);
+        link["mass"] = i + 0.5;
+        link["shapes"].push_back(i);
+        link["shapes"].push_back(std::string("box"));
+    }
+    map["name"] = "robot";
+    std::string text = map.toYamlString();
+    YAML::Node node = YAML::Load(text);
+
+    resetAllocationStats();
+    size_t before = liveBytes;
+    ConfigItem eager(node);
+    size_t eagerBytes = liveBytes - before;
+
+    before = liveBytes;
+    ConfigItem lazy = ConfigItem::fromYamlNodeLazy(node);
+    REQUIRE((std::string)lazy["name"] == "robot");
+    REQUIRE((double)lazy["link7"]["mass"] == 7.5);
+    // only the top level map and one link are converted
+    REQUIRE(liveBytes - before < eagerBytes / 4);
+
+    const ConfigItem copy = ConfigItem::fromYamlStringLazy(text);
+    REQUIRE(copy.isMap());
+    REQUIRE(copy.size() == 2001);
+    REQUIRE(copy.toYamlString() == text);
+    REQUIRE(lazy.toYamlString() == text);
+
+    lazy["link3"]["shapes"][1] = "sphere";
+    REQUIRE((std::string)lazy["link3"]["shapes"][1] == "sphere");
+    REQUIRE(lazy["link3"]["shapes"][1].getPath() == "/link3/shapes/1");
+    REQUIRE((std::string)eager["link3"]["shapes"][1] == "box");
+    REQUIRE((int)ConfigItem::fromYamlStringLazy("- [1, 2]\n- 3\n")[0][1] == 2);
+}
+
+TEST_CASE("parallel_includes", "loads URI includes concurrently with a deterministic merge")
+{
+    std::filesystem::remove_all("include_test");
+    std::filesystem::create_directories("include_test/parts");
+    std::string main = "name: robot\nmass: 1\nlinks:\n";
+    for (int i = 0; i < 40; ++i)
+    {
+        std::string n = std::to_string(i);
+        main += "  - URI: parts/link" + n + ".yml\n";
+        writeTextFile("include_test/parts/link" + n + ".yml",
+                      "name: link" + n + "\nwheels:\n  - URI: wheel.yml\n  - URI: wheel.yml\n");
+    }
+    main += "URI: override.yml\n";
+    writeTextFile("include_test/main.yml", main);
+    writeTextFile("include_test/override.yml", "mass: 2\nextra: true\n");
+    writeTextFile("include_test/parts/wheel.yml", "radius: 0.3\n");
+
+    ConfigMap map = ConfigMap::fromYamlFile("include_test/main.yml", true);
+    REQUIRE((int)map["mass"] == 2);
+    REQUIRE((bool)map["extra"]);
+    REQUIRE(!map.hasKey("URI"));
+    REQUIRE(map["links"].size() == 40);
+    REQUIRE((std::string)map["links"][39]["name"] == "link39");
+    REQUIRE((double)map["links"][7]["wheels"][1]["radius"] == 0.3);
+    std::string text = map.toYamlString();
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(ConfigMap::fromYamlFile("include_test/main.yml", true).toYamlString() == text);
+    }
+
+    writeTextFile("include_test/parts/wheel.yml", "URI: ../parts/wheel.yml\n");
+    REQUIRE_THROWS_AS(ConfigMap::fromYamlFile("include_test/main.yml", true), std::runtime_error);
+    std::filesystem::remove("include_test/parts/wheel.yml");
+    REQUIRE_THROWS_AS(ConfigMap::fromYamlFile("include_test/main.yml", true), std::runtime_error);
+    std::filesystem::remove_all("include_test");
+}
+
+TEST_CASE("parsed_file_cache", "parses unchanged files once per process")
+{
+    std::filesystem::remove_all("parsed_cache_test");
+    std::filesystem::create_directories("parsed_cache_test");
+    std::string path = "parsed_cache_test/robot.yml";
+    writeTextFile(path, "name: robot\n");
+    auto mtime = std::filesystem::last_write_time(path);
+
+    ConfigItem::enableParsedFileCache();
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "robot");
+
+    // same size and time, thus the cached tree is used
+    writeTextFile(path, "name: cache\n");
+    std::filesystem::last_write_time(path, mtime);
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "robot");
+    REQUIRE((std::string)ConfigMap::fromYamlFile("parsed_cache_test/../" + path)["name"] == "robot");
+
+    // the copies do not share the cached tree
+    ConfigMap copy = ConfigMap::fromYamlFile(path);
+    copy["name"] = "changed";
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "robot");
+
+    writeTextFile(path, "name: changed\n");
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "changed");
+
+    // included files stay shared with the cached tree until they change
+    writeTextFile("parsed_cache_test/main.yml", "parts:\n  URI: part.yml\n");
+    writeTextFile("parsed_cache_test/part.yml", "link: {mass: 1.5}\n");
+    auto linkNode = [](const ConfigMap &map) {
+        const ConfigItem &parts = map.at("parts");
+        return static_cast<const ConfigMap&>((const ConfigBase&)parts).at("link").getNode();
+    };
+    ConfigMap first = ConfigMap::fromYamlFile("parsed_cache_test/main.yml", true);
+    ConfigMap second = ConfigMap::fromYamlFile("parsed_cache_test/main.yml", true);
+    REQUIRE(linkNode(first) == linkNode(second));
+    first["parts"]["link"]["mass"] = 2.5;
+    REQUIRE(linkNode(first) != linkNode(second));
+    REQUIRE((double)second["parts"]["link"]["mass"] == 1.5);
+    REQUIRE((double)ConfigMap::fromYamlFile("parsed_cache_test/main.yml", true)["parts"]["link"]["mass"] == 1.5);
+
+    // nothing fits into a tiny budget
+    ConfigItem::enableParsedFileCache(16);
+    writeTextFile(path, "name: tinyyy\n");
+    std::filesystem::last_write_time(path, mtime);
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "tinyyy");
+    writeTextFile(path, "name: budget\n");
+    std::filesystem::last_write_time(path, mtime);
+    REQUIRE((std::string)ConfigMap::fromYamlFile(path)["name"] == "budget");
+
+    ConfigItem::disableParsedFileCache();
+    std::filesystem::remove_all("parsed_cache_test");
+}
+
+TEST_CASE("copy_on_write", "shares subtrees between copies until one of them changes")
+{
+    size_t before = liveBytes;
+    ConfigItem item;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ConfigItem &link = item["robot"]["links"][(size_t)i];
+        link["name"] = "link" + std::to_string(i);
+        link["mass"] = i + 0.5;
+    }
+    size_t treeBytes = liveBytes - before;
+
+    // the tree was built through references, the first copy duplicates it
+    ConfigItem clone = item;
+    resetAllocationStats();
+    ConfigItem copy = clone;
+    REQUIRE(allocationCount == 0);
+
+    before = liveBytes;
+    copy["robot"]["links"][1]["mass"] = 5.0;
+    // the root map, robot, the items of the links vector and one link
+    REQUIRE(liveBytes - before < treeBytes / 3);
+
+    REQUIRE((double)copy["robot"]["links"][1]["mass"] == 5.0);
+    REQUIRE((double)item["robot"]["links"][1]["mass"] == 1.5);
+    REQUIRE((double)copy["robot"]["links"][2]["mass"] == 2.5);
+    REQUIRE((double)clone["robot"]["links"][1]["mass"] == 1.5);
+    REQUIRE(copy["robot"]["links"][1]["mass"].getPath() == "/robot/links/1/mass");
+    REQUIRE(item["robot"]["links"][1]["mass"].getPath() == "/robot/links/1/mass");
+
+    ConfigMap links = item["robot"];
+    links["links"][0]["name"] = "changed";
+    REQUIRE((std::string)item["robot"]["links"][0]["name"] == "link0");
+    REQUIRE(copy.toYamlString() != item.toYamlString());
+    copy["robot"]["links"][1]["mass"] = 1.5;
+    REQUIRE(copy.toYamlString() == item.toYamlString());
+
+    // a subtree copied into its own tree
+    item["robot"]["backup"] = item["robot"];
+    item["robot"]["backup"]["links"][0]["name"] = "backup";
+    REQUIRE((std::string)item["robot"]["links"][0]["name"] == "link0");
+    REQUIRE((std::string)item["robot"]["backup"]["links"][0]["name"] == "backup");
+    // the tree does not contain itself
+    REQUIRE(ConfigItem::fromBinary(item.toBinary())["robot"]["backup"].size() == 2);
+}
+
+TEST_CASE("copy_on_write_references", "does not share nodes that handed out references")
+{
+    ConfigItem loaded = ConfigItem::fromYamlString("a: {x: 1}\nv: [1, 2]\n");
+    resetAllocationStats();
+    ConfigItem loadedCopy = loaded;
+    REQUIRE(allocationCount == 0);
+
+    ConfigMap root = ConfigMap::fromYamlString("a: {x: 1}\nv: [1, 2]\n");
+    ConfigMap &sub = root["a"];
+    ConfigMap copy = root;
+    sub["b"] = 2;
+    REQUIRE(root["a"].hasKey("b"));
+    REQUIRE(!copy["a"].hasKey("b"));
+
+    ConfigVector &vector = root["v"];
+    ConfigMap vectorCopy = root;
+    vector[0] = 5;
+    vector.append(ConfigItem(3));
+    REQUIRE((int)root["v"][0] == 5);
+    REQUIRE((int)vectorCopy["v"][0] == 1);
+    REQUIRE(vectorCopy["v"].size() == 2);
+
+    // the const conversions hand out a map that can be changed as well
+    ConfigItem item = ConfigItem::fromYamlString("a: {x: 1}\n");
+    const ConfigItem &constItem = item;
+    ConfigMap &map = constItem;
+    ConfigItem constCopy = constItem;
+    map["b"] = 2;
+    REQUIRE(item.hasKey("b"));
+    REQUIRE(!constCopy.hasKey("b"));
+
+    ConfigItem lazy = ConfigItem::fromYamlStringLazy("a: {x: 1}\n");
+    ConfigMap &lazyMap = lazy["a"];
+    ConfigItem lazyCopy = lazy;
+    lazyMap["b"] = 2;
+    REQUIRE(lazy["a"].hasKey("b"));
+    REQUIRE(!lazyCopy["a"].hasKey("b"));
+}
+
+TEST_CASE("compiled_schema", "validates against the schema compiled at construction")
+{
+    ConfigMap schema = ConfigMap::fromYamlString(
+        "mass: {type: number, required: true, minimum: 0}\n"
+        "links:\n"
+        "  type: array\n"
+        "  contains:\n"
+        "    type: object\n"
+        "    properties:\n"
+        "      name: {type: string, required: true}\n"
+        "      id: {type: integer, maximum: 10}\n");
+    ConfigSchema cs(schema);
+    // the schema is not read again
+    schema["mass"]["type"] = "string";
+
+    ConfigMap config = ConfigMap::fromYamlString(
+        "mass: 1.5\nlinks: [{name: a, id: 1}, {name: b}]\n");
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(cs.validate(config));
+    }
+    config["mass"] = -1.0;
+    // a violated open bound does not change the schema
+    REQUIRE(!cs.validate(config));
+    REQUIRE(!cs.validate(config));
+    config["mass"] = 2;
+    REQUIRE(cs.validate(config));
+    config["links"][1]["id"] = 11;
+    REQUIRE(!cs.validate(config));
+    config["links"][1]["id"] = 10;
+    auto name = config["links"][0].find("name");
+    config["links"][0].erase(name);
+    REQUIRE(!cs.validate(config));
+
+    ConfigSchema broken(ConfigMap::fromYamlString("a: [1]\n"));
+    REQUIRE_THROWS(broken.validate(config));
+    REQUIRE(ConfigSchema().validate(config));
+}